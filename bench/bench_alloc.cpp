@@ -0,0 +1,57 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2020 Kevin Xu
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include <cstdio>
+#include "shared_buf.hpp"
+#include "bench_common.hpp"
+
+/*
+ *  Compares alloc/free throughput of shared_buf(size_t), which performs separate
+ *  allocations for the bytes and the control block, against make_shared_buf(size_t)
+ */
+
+int main()
+{
+  const size_t iterations = 2000000;
+  const size_t sizes[] = {64, 512, 4096, 65536};
+
+  for (size_t sz : sizes)
+  {
+    std::printf("size=%zu\n", sz);
+
+    bench::run("  shared_buf(sz)", iterations, [&](size_t i)
+    {
+      xu::shared_buf buf(sz);
+      buf[0] = (uint8_t)i;
+      bench::doNotOptimize(buf[0]);
+    });
+
+    bench::run("  make_shared_buf(sz)", iterations, [&](size_t i)
+    {
+      xu::shared_buf buf = xu::make_shared_buf(sz);
+      buf[0] = (uint8_t)i;
+      bench::doNotOptimize(buf[0]);
+    });
+  }
+}
@@ -0,0 +1,95 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2020 Kevin Xu
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "shared_buf_builder.hpp"
+#include "bench_common.hpp"
+
+/*
+ *  Building a buffer of unknown length from chunks: std::vector then a copy into a
+ *  shared_buf, vs shared_buf_builder with heap-only growth, vs the default builder, whose
+ *  storage grows with mremap() past 1 MiB
+ */
+
+template<typename Fn>
+static void benchBuild(const char* label, size_t total, size_t chunk_sz, Fn&& build)
+{
+  std::vector<uint8_t> chunk(chunk_sz, 0x5a);
+  char name[96];
+  std::snprintf(name, sizeof(name), "  %s", label);
+
+  size_t iterations = std::max<size_t>(1, (size_t(1) << 30) / total);
+  bench::runBytes(name, iterations, total, [&](size_t)
+  {
+    xu::shared_buf buf = build(chunk, total);
+    bench::doNotOptimize(buf.data()[buf.size() - 1]);
+  });
+}
+
+int main()
+{
+  const size_t chunk_sz = 4096;
+  const size_t totals[] = {size_t(16) << 10, size_t(4) << 20, size_t(256) << 20};
+
+  for (size_t total : totals)
+  {
+    std::printf("total=%zu KiB in %zu B chunks\n", total >> 10, chunk_sz);
+
+    benchBuild("std::vector + copy", total, chunk_sz, [](const std::vector<uint8_t>& chunk, size_t n)
+    {
+      std::vector<uint8_t> vec;
+      for (size_t done = 0; done < n; done += chunk.size())
+      {
+        vec.insert(vec.end(), chunk.begin(), chunk.end());
+      }
+      xu::shared_buf buf = xu::make_shared_buf(vec.size());
+      std::memcpy(buf.data(), vec.data(), vec.size());
+      return buf;
+    });
+
+    benchBuild("shared_buf_builder, heap only", total, chunk_sz, [](const std::vector<uint8_t>& chunk, size_t n)
+    {
+      xu::shared_buf_builder builder(0, SIZE_MAX);
+      for (size_t done = 0; done < n; done += chunk.size())
+      {
+        builder.append(chunk.data(), chunk.size());
+      }
+      return builder.finish();
+    });
+
+    benchBuild("shared_buf_builder, mremap", total, chunk_sz, [](const std::vector<uint8_t>& chunk, size_t n)
+    {
+      xu::shared_buf_builder builder;
+      for (size_t done = 0; done < n; done += chunk.size())
+      {
+        builder.append(chunk.data(), chunk.size());
+      }
+      return builder.finish();
+    });
+  }
+}
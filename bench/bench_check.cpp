@@ -0,0 +1,107 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2020 Kevin Xu
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include <cstdio>
+
+#include "shared_buf.hpp"
+#include "bench_common.hpp"
+
+/*
+ *  Cost of the XU_SHARED_BUF_CHECK policy on operator[] in inner loops
+ *  The policy is a build macro, so build once per policy, e.g.
+ *    for p in NONE ASSERT THROW HARDENED; do
+ *      g++ -std=c++20 -O3 -DNDEBUG -DXU_SHARED_BUF_CHECK=XU_SHARED_BUF_CHECK_$p \
+ *        -Iinclude bench/bench_check.cpp -o bench_check_$p && ./bench_check_$p
+ *    done
+ *  Inspect the generated code of sumBytes()/scaleBytes() with -S to see which loops vectorize
+ */
+
+#if XU_SHARED_BUF_CHECK == XU_SHARED_BUF_CHECK_NONE
+static const char* policy = "none";
+#elif XU_SHARED_BUF_CHECK == XU_SHARED_BUF_CHECK_ASSERT
+static const char* policy = "assert";
+#elif XU_SHARED_BUF_CHECK == XU_SHARED_BUF_CHECK_THROW
+static const char* policy = "throw";
+#else
+static const char* policy = "hardened";
+#endif
+
+__attribute__((noinline)) static uint32_t sumBytes(const xu::shared_buf& buf)
+{
+  uint32_t sum = 0;
+  for (size_t i = 0; i < buf.size(); i++)
+  {
+    sum += buf[i];
+  }
+  return sum;
+}
+
+__attribute__((noinline)) static void scaleBytes(xu::shared_buf& dst, const xu::shared_buf& src)
+{
+  for (size_t i = 0; i < src.size(); i++)
+  {
+    dst[i] = src[i] * 3;
+  }
+}
+
+__attribute__((noinline)) static uint32_t sumBytesAt(const xu::shared_buf& buf)
+{
+  uint32_t sum = 0;
+  for (size_t i = 0; i < buf.size(); i++)
+  {
+    sum += buf.at(i);
+  }
+  return sum;
+}
+
+int main()
+{
+  const size_t sz = 64 << 10;
+  const size_t iterations = 5000;
+
+  xu::shared_buf src = xu::make_shared_buf(sz);
+  xu::shared_buf dst = xu::make_shared_buf(sz);
+  for (size_t i = 0; i < sz; i++)
+  {
+    src.at(i) = (uint8_t)i;
+  }
+
+  std::printf("policy=%s\n", policy);
+
+  bench::runBytes("  sum via operator[]", iterations, sz, [&](size_t)
+  {
+    bench::doNotOptimize(sumBytes(src));
+  });
+
+  bench::runBytes("  scale via operator[]", iterations, sz, [&](size_t)
+  {
+    scaleBytes(dst, src);
+    bench::doNotOptimize(dst.data()[0]);
+  });
+
+  bench::runBytes("  sum via at()", iterations, sz, [&](size_t)
+  {
+    bench::doNotOptimize(sumBytesAt(src));
+  });
+}
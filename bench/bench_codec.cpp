@@ -0,0 +1,139 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2020 Kevin Xu
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include <cstdio>
+#include <string>
+
+#include "shared_buf.hpp"
+#include "bench_common.hpp"
+
+/*
+ *  Decoding throughput of fromHex/fromBase64 against straightforward scalar loops
+ *  Build with -mssse3 (or -march=native) to enable the vectorized Base64 kernel
+ */
+
+static int naiveHexValue(char c)
+{
+  if (c >= '0' and c <= '9')
+  {
+    return c - '0';
+  }
+  if (c >= 'a' and c <= 'f')
+  {
+    return c - 'a' + 10;
+  }
+  if (c >= 'A' and c <= 'F')
+  {
+    return c - 'A' + 10;
+  }
+  return -1;
+}
+
+static xu::shared_buf naiveFromHex(const std::string& hex)
+{
+  xu::shared_buf buf(hex.size() / 2);
+  for (size_t i = 0; i < buf.size(); i++)
+  {
+    buf[i] = (uint8_t)(naiveHexValue(hex[2 * i]) << 4 | naiveHexValue(hex[2 * i + 1]));
+  }
+  return buf;
+}
+
+static xu::shared_buf naiveFromBase64(const std::string& b64)
+{
+  static const std::string alphabet =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+  size_t len = b64.size() / 4 * 3;
+  if (not b64.empty() and b64[b64.size() - 1] == '=')
+  {
+    len--;
+  }
+  if (b64.size() > 1 and b64[b64.size() - 2] == '=')
+  {
+    len--;
+  }
+
+  xu::shared_buf buf(len);
+  uint32_t word = 0;
+  size_t bits = 0;
+  size_t pos = 0;
+  for (char c : b64)
+  {
+    if (c == '=')
+    {
+      break;
+    }
+    word = word << 6 | (uint32_t)alphabet.find(c);
+    bits += 6;
+    if (bits >= 8)
+    {
+      bits -= 8;
+      buf[pos++] = (uint8_t)(word >> bits);
+    }
+  }
+  return buf;
+}
+
+int main()
+{
+  const size_t sz = size_t(1) << 20;
+  const size_t iterations = 200;
+
+  xu::shared_buf buf = xu::make_shared_buf(sz);
+  for (size_t i = 0; i < sz; i++)
+  {
+    buf[i] = (uint8_t)(i * 131 + (i >> 9));
+  }
+
+  std::string hex = buf.toHex(xu::compact_hex());
+  std::string b64 = buf.toBase64();
+
+  std::printf("decoded size=%zu (GB/s measured on decoded bytes)\n", sz);
+
+  bench::runBytes("hex: naive loop", iterations, sz, [&](size_t)
+  {
+    bench::doNotOptimize(naiveFromHex(hex).data());
+  });
+
+  bench::runBytes("hex: shared_buf::fromHex", iterations, sz, [&](size_t)
+  {
+    bench::doNotOptimize(xu::shared_buf::fromHex(hex).data());
+  });
+
+  bench::runBytes("base64: naive loop", iterations, sz, [&](size_t)
+  {
+    bench::doNotOptimize(naiveFromBase64(b64).data());
+  });
+
+  bench::runBytes("base64: shared_buf::fromBase64", iterations, sz, [&](size_t)
+  {
+    bench::doNotOptimize(xu::shared_buf::fromBase64(b64).data());
+  });
+
+  bench::runBytes("base64: shared_buf::toBase64", iterations, sz, [&](size_t)
+  {
+    bench::doNotOptimize(buf.toBase64().data());
+  });
+}
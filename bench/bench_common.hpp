@@ -0,0 +1,79 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2020 Kevin Xu
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+namespace bench
+{
+  /**
+    @brief  Prevents the compiler from optimizing away a computed value
+    */
+  template<typename T>
+  inline void doNotOptimize(const T& value)
+  {
+    asm volatile("" : : "r,m"(value) : "memory");
+  }
+
+  /**
+    @brief  Runs fn(i) for i in [0, iterations) and prints the mean time per iteration
+    @return Mean nanoseconds per iteration
+    */
+  template<typename Fn>
+  inline double run(const char* name, size_t iterations, Fn&& fn)
+  {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; i++)
+    {
+      fn(i);
+    }
+    auto stop = std::chrono::steady_clock::now();
+
+    double ns = std::chrono::duration<double, std::nano>(stop - start).count() / iterations;
+    std::printf("%-48s %12.2f ns/op\n", name, ns);
+    return ns;
+  }
+
+  /**
+    @brief  Like run(), but also prints throughput given the number of bytes per iteration
+    */
+  template<typename Fn>
+  inline double runBytes(const char* name, size_t iterations, size_t bytes, Fn&& fn)
+  {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; i++)
+    {
+      fn(i);
+    }
+    auto stop = std::chrono::steady_clock::now();
+
+    double ns = std::chrono::duration<double, std::nano>(stop - start).count() / iterations;
+    std::printf("%-48s %12.2f ns/op %10.2f GB/s\n", name, ns, bytes / ns);
+    return ns;
+  }
+}
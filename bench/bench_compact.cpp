@@ -0,0 +1,87 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2020 Kevin Xu
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include "shared_buf_intrusive.hpp"
+#include "bench_common.hpp"
+
+/*
+ *  Footprint and copy throughput of large collections of handles, each to its own buffer,
+ *  as in a queue or map holding many messages
+ */
+
+template<typename Buf_T, typename Make_T>
+static void benchHandles(const char* label, size_t count, Make_T&& make)
+{
+  std::vector<Buf_T> handles;
+  handles.reserve(count);
+  for (size_t i = 0; i < count; i++)
+  {
+    handles.push_back(make());
+  }
+
+  std::printf("%-24s %2zu B/handle, %7.1f MiB for %zu handles\n", label, sizeof(Buf_T),
+    sizeof(Buf_T) * count / 1048576.0, count);
+
+  const size_t rounds = 5;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t r = 0; r < rounds; r++)
+  {
+    std::vector<Buf_T> copy = handles;
+    bench::doNotOptimize(copy.data());
+  }
+  auto stop = std::chrono::steady_clock::now();
+
+  double ns = std::chrono::duration<double, std::nano>(stop - start).count() / (rounds * count);
+  std::printf("%-24s copy+destroy %6.2f ns/handle\n", "", ns);
+}
+
+int main()
+{
+  const size_t count = 4000000;
+  const size_t sz = 32;
+
+  benchHandles<xu::shared_buf>("shared_buf", count, [&]()
+  {
+    return xu::make_shared_buf(sz);
+  });
+
+  benchHandles<xu::shared_buf>("shared_buf slice", count, [&]()
+  {
+    return xu::make_shared_buf(sz).slice(8, 16);
+  });
+
+  benchHandles<xu::compact_shared_buf>("compact_shared_buf", count, [&]()
+  {
+    return xu::compact_shared_buf(sz);
+  });
+
+  benchHandles<xu::compact_shared_slice>("compact_shared_slice", count, [&]()
+  {
+    return xu::compact_shared_buf(sz).slice(8, 16);
+  });
+}
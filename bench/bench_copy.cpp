@@ -0,0 +1,92 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2020 Kevin Xu
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+#include "shared_buf.hpp"
+#include "bench_common.hpp"
+
+/*
+ *  deepCopy() against memcpy into a preallocated buffer, and against the original
+ *  byte-by-byte loop through shared_ptr<uint8_t[]>::operator[]
+ */
+
+int main()
+{
+  const size_t sizes[] = {size_t(4) << 10, size_t(256) << 10, size_t(4) << 20, size_t(100) << 20};
+
+  xu::copy_options threaded;
+  threaded.threads = std::thread::hardware_concurrency();
+
+  for (size_t sz : sizes)
+  {
+    size_t iterations = (size_t(1) << 30) / sz;
+    if (iterations > 100000)
+    {
+      iterations = 100000;
+    }
+
+    xu::shared_buf src = xu::make_shared_buf(sz);
+    std::memset(src.data(), 0x5a, sz);
+    xu::shared_buf dst = xu::make_shared_buf(sz);
+
+    std::printf("size=%zu\n", sz);
+
+    bench::runBytes("  memcpy (preallocated)", iterations, sz, [&](size_t)
+    {
+      std::memcpy(dst.data(), src.data(), sz);
+      bench::doNotOptimize(dst.data()[0]);
+    });
+
+    bench::runBytes("  copy_bytes (preallocated)", iterations, sz, [&](size_t)
+    {
+      xu::copy_bytes(dst.data(), src.data(), sz);
+      bench::doNotOptimize(dst.data()[0]);
+    });
+
+    bench::runBytes("  byte loop (original deepCopy)", iterations / 4 + 1, sz, [&](size_t)
+    {
+      xu::shared_buf copy(sz);
+      for (size_t i = 0; i < sz; i++)
+      {
+        copy[i] = src[i];
+      }
+      bench::doNotOptimize(copy.data()[0]);
+    });
+
+    bench::runBytes("  deepCopy()", iterations, sz, [&](size_t)
+    {
+      xu::shared_buf copy = src.deepCopy();
+      bench::doNotOptimize(copy.data()[0]);
+    });
+
+    bench::runBytes("  deepCopy(threaded)", iterations, sz, [&](size_t)
+    {
+      xu::shared_buf copy = src.deepCopy(threaded);
+      bench::doNotOptimize(copy.data()[0]);
+    });
+  }
+}
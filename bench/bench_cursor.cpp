@@ -0,0 +1,162 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2020 Kevin Xu
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include <bit>
+#include <cstdio>
+#include <vector>
+
+#include "shared_buf_cursor.hpp"
+#include "bench_common.hpp"
+
+/*
+ *  Decoding a 40-byte big-endian message header:
+ *    magic u32, version u16, flags u16, type u8, priority u8, channel u16,
+ *    length u32, sequence u64, timestamp u64, price f64
+ *  byte by byte through shared_buf::operator[], vs buf_reader with a check per field, vs
+ *  buf_reader::record() with one check per header
+ */
+
+struct header
+{
+  uint32_t magic;
+  uint16_t version;
+  uint16_t flags;
+  uint8_t type;
+  uint8_t priority;
+  uint16_t channel;
+  uint32_t length;
+  uint64_t sequence;
+  uint64_t timestamp;
+  double price;
+};
+
+static const size_t header_size = 40;
+
+template<typename T>
+static T loadBytes(const xu::shared_buf& buf, size_t at)
+{
+  T v = 0;
+  for (size_t i = 0; i < sizeof(T); i++)
+  {
+    v = (T)((v << 8) | buf[at + i]);
+  }
+  return v;
+}
+
+__attribute__((noinline)) static header decodeBytes(const xu::shared_buf& buf, size_t at)
+{
+  header h;
+  h.magic = loadBytes<uint32_t>(buf, at);
+  h.version = loadBytes<uint16_t>(buf, at + 4);
+  h.flags = loadBytes<uint16_t>(buf, at + 6);
+  h.type = buf[at + 8];
+  h.priority = buf[at + 9];
+  h.channel = loadBytes<uint16_t>(buf, at + 10);
+  h.length = loadBytes<uint32_t>(buf, at + 12);
+  h.sequence = loadBytes<uint64_t>(buf, at + 16);
+  h.timestamp = loadBytes<uint64_t>(buf, at + 24);
+  h.price = std::bit_cast<double>(loadBytes<uint64_t>(buf, at + 32));
+  return h;
+}
+
+template<typename Reader_T>
+static header decodeFields(Reader_T& r)
+{
+  header h;
+  h.magic = r.readU32();
+  h.version = r.readU16();
+  h.flags = r.readU16();
+  h.type = r.readU8();
+  h.priority = r.readU8();
+  h.channel = r.readU16();
+  h.length = r.readU32();
+  h.sequence = r.readU64();
+  h.timestamp = r.readU64();
+  h.price = r.readF64();
+  return h;
+}
+
+__attribute__((noinline)) static header decodeChecked(xu::buf_reader<>& r)
+{
+  return decodeFields(r);
+}
+
+__attribute__((noinline)) static header decodeRecord(xu::buf_reader<>& r)
+{
+  auto rec = r.record(header_size);
+  return decodeFields(rec);
+}
+
+int main()
+{
+  const size_t count = 4096;
+  const size_t rounds = 500;
+
+  xu::shared_buf buf = xu::make_shared_buf(count * header_size);
+  xu::buf_writer writer(buf);
+  for (size_t i = 0; i < count; i++)
+  {
+    writer.writeU32(0x58554246);
+    writer.writeU16(1);
+    writer.writeU16((uint16_t)i);
+    writer.writeU8(3);
+    writer.writeU8(0);
+    writer.writeU16((uint16_t)(i % 16));
+    writer.writeU32((uint32_t)(i * 7));
+    writer.writeU64(i);
+    writer.writeU64(1700000000000000000ull + i);
+    writer.writeF64(100.25 + i);
+  }
+
+  uint64_t sum = 0;
+
+  bench::runBytes("operator[] byte by byte", rounds * count, header_size, [&](size_t i)
+  {
+    header h = decodeBytes(buf, (i % count) * header_size);
+    sum += h.sequence + h.length;
+  });
+
+  xu::buf_reader reader(buf);
+  bench::runBytes("buf_reader, check per field", rounds * count, header_size, [&](size_t i)
+  {
+    if (i % count == 0)
+    {
+      reader = xu::buf_reader(buf);
+    }
+    header h = decodeChecked(reader);
+    sum += h.sequence + h.length;
+  });
+
+  bench::runBytes("buf_reader::record(), one check", rounds * count, header_size, [&](size_t i)
+  {
+    if (i % count == 0)
+    {
+      reader = xu::buf_reader(buf);
+    }
+    header h = decodeRecord(reader);
+    sum += h.sequence + h.length;
+  });
+
+  bench::doNotOptimize(sum);
+}
@@ -0,0 +1,95 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2020 Kevin Xu
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include <cstdio>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+#include "shared_buf.hpp"
+#include "bench_common.hpp"
+
+/*
+ *  Formatting a 4 KiB packet: the original per-byte iostream print() vs the table-driven
+ *  formatter, both into a stream and into a caller-supplied buffer
+ */
+
+static std::ostream& printIostream(std::ostream& stream, const xu::shared_buf& buf)
+{
+  std::ios_base::fmtflags orig_stream_flags(stream.flags());
+  stream << std::resetiosflags(orig_stream_flags);
+
+  stream << '[' << std::hex;
+  for (size_t i = 0; i < buf.size(); i++)
+  {
+    if (i != 0)
+    {
+      stream << ',';
+    }
+    stream << std::setw(2) << std::setfill('0') << (int)buf[i];
+  }
+  stream << ']';
+
+  stream.flags(orig_stream_flags);
+  return stream;
+}
+
+int main()
+{
+  const size_t sz = 4096;
+  const size_t iterations = 5000;
+
+  xu::shared_buf buf = xu::make_shared_buf(sz);
+  for (size_t i = 0; i < sz; i++)
+  {
+    buf[i] = (uint8_t)(i * 31);
+  }
+
+  std::ostringstream stream;
+  std::vector<char> out(xu::hex_length(sz));
+
+  bench::runBytes("iostream per byte (original print)", iterations, sz, [&](size_t)
+  {
+    stream.str("");
+    printIostream(stream, buf);
+    bench::doNotOptimize(stream.tellp());
+  });
+
+  bench::runBytes("print() into ostringstream", iterations, sz, [&](size_t)
+  {
+    stream.str("");
+    buf.print(stream);
+    bench::doNotOptimize(stream.tellp());
+  });
+
+  bench::runBytes("format_hex() into char buffer", iterations, sz, [&](size_t)
+  {
+    bench::doNotOptimize(xu::format_hex(out.data(), buf.data(), sz));
+  });
+
+  bench::runBytes("format_hex(compact) into char buffer", iterations, sz, [&](size_t)
+  {
+    bench::doNotOptimize(xu::format_hex(out.data(), buf.data(), sz, xu::compact_hex()));
+  });
+}
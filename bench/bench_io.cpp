@@ -0,0 +1,75 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2020 Kevin Xu
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include <cstdio>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "shared_buf_io.hpp"
+#include "bench_common.hpp"
+
+/*
+ *  Flushing a message made of many fragments: one write(2) per fragment vs xu::write_to
+ */
+
+int main()
+{
+  int fd = ::open("/dev/null", O_WRONLY);
+  if (fd < 0)
+  {
+    std::perror("open");
+    return 1;
+  }
+
+  const size_t iterations = 20000;
+  const size_t fragment_counts[] = {4, 16, 64, 256};
+
+  for (size_t count : fragment_counts)
+  {
+    std::vector<xu::shared_buf> frags;
+    for (size_t i = 0; i < count; i++)
+    {
+      frags.push_back(xu::make_shared_buf(128));
+    }
+
+    std::printf("fragments=%zu\n", count);
+
+    bench::run("  write() per fragment", iterations, [&](size_t)
+    {
+      for (const auto& frag : frags)
+      {
+        bench::doNotOptimize(::write(fd, frag.data(), frag.size()));
+      }
+    });
+
+    bench::run("  xu::write_to(fd, fragments)", iterations, [&](size_t)
+    {
+      bench::doNotOptimize(xu::write_to(fd, frags));
+    });
+  }
+
+  ::close(fd);
+}
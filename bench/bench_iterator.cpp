@@ -0,0 +1,95 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2020 Kevin Xu
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <numeric>
+
+#include "shared_buf.hpp"
+#include "bench_common.hpp"
+
+/*
+ *  Standard algorithms over the bounds-checked iterator_ vs the contiguous_iterator_
+ *  (which iterator/const_iterator alias depending on XU_SHARED_BUF_CHECKED_ITERATORS)
+ *  Build with -O3, where the compiler vectorizes loops over the contiguous iterator
+ */
+
+using checked = xu::shared_buf::iterator_<uint8_t>;
+using contiguous = xu::shared_buf::contiguous_iterator_<uint8_t>;
+
+int main()
+{
+  const size_t sz = 64 << 10;
+  const size_t iterations = 2000;
+
+  xu::shared_buf src = xu::make_shared_buf(sz);
+  xu::shared_buf dst = xu::make_shared_buf(sz);
+  std::fill(src.data(), src.data() + sz, 1);
+  src[sz - 1] = 0xff;
+
+  checked src_cb(src.data(), sz), src_ce(src.data(), sz, sz), dst_cb(dst.data(), sz);
+  contiguous src_b(src.data()), src_e(src.data() + sz), dst_b(dst.data());
+
+  std::printf("size=%zu\n", sz);
+
+  bench::runBytes("std::copy      checked", iterations, sz, [&](size_t)
+  {
+    std::copy(src_cb, src_ce, dst_cb);
+    bench::doNotOptimize(dst[0]);
+  });
+  bench::runBytes("std::copy      contiguous", iterations, sz, [&](size_t)
+  {
+    std::copy(src_b, src_e, dst_b);
+    bench::doNotOptimize(dst[0]);
+  });
+
+  bench::runBytes("std::find      checked", iterations, sz, [&](size_t)
+  {
+    bench::doNotOptimize(std::find(src_cb, src_ce, 0xff) - src_cb);
+  });
+  bench::runBytes("std::find      contiguous", iterations, sz, [&](size_t)
+  {
+    bench::doNotOptimize(std::find(src_b, src_e, 0xff) - src_b);
+  });
+
+  bench::runBytes("std::transform checked", iterations, sz, [&](size_t)
+  {
+    std::transform(src_cb, src_ce, dst_cb, [](uint8_t b) { return (uint8_t)(b + 1); });
+    bench::doNotOptimize(dst[0]);
+  });
+  bench::runBytes("std::transform contiguous", iterations, sz, [&](size_t)
+  {
+    std::transform(src_b, src_e, dst_b, [](uint8_t b) { return (uint8_t)(b + 1); });
+    bench::doNotOptimize(dst[0]);
+  });
+
+  bench::runBytes("std::accumulate checked", iterations, sz, [&](size_t)
+  {
+    bench::doNotOptimize(std::accumulate(src_cb, src_ce, 0u));
+  });
+  bench::runBytes("std::accumulate contiguous", iterations, sz, [&](size_t)
+  {
+    bench::doNotOptimize(std::accumulate(src_b, src_e, 0u));
+  });
+}
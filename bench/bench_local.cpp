@@ -0,0 +1,73 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2020 Kevin Xu
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include <cstdio>
+#include <vector>
+
+#include "shared_buf_intrusive.hpp"
+#include "bench_common.hpp"
+
+/*
+ *  Copy and destroy cost of a handle on a single thread: shared_buf pays an atomic increment
+ *  and decrement on the control block, local_shared_buf a plain one on its header
+ */
+
+template<typename Buf_T>
+static void benchHandle(const char* label, Buf_T buf, size_t iterations)
+{
+  const size_t fanout = 64;
+  char name[64];
+
+  std::snprintf(name, sizeof(name), "%s copy+destroy", label);
+  bench::run(name, iterations, [&](size_t)
+  {
+    Buf_T copy = buf;
+    bench::doNotOptimize(copy);
+  });
+
+  /*
+   *  Fan-out, e.g. queueing one message to several connections, then draining them
+   */
+  std::vector<Buf_T> copies;
+  copies.reserve(fanout);
+
+  std::snprintf(name, sizeof(name), "%s fan-out x%zu", label, fanout);
+  bench::run(name, iterations / fanout, [&](size_t)
+  {
+    for (size_t i = 0; i < fanout; i++)
+    {
+      copies.push_back(buf);
+    }
+    bench::doNotOptimize(copies.data());
+    copies.clear();
+  });
+}
+
+int main()
+{
+  const size_t iterations = 20000000;
+
+  benchHandle("shared_buf", xu::make_shared_buf(64), iterations);
+  benchHandle("local_shared_buf", xu::local_shared_buf(64), iterations);
+}
@@ -0,0 +1,108 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2020 Kevin Xu
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "shared_buf_io.hpp"
+#include "shared_buf_mmap.hpp"
+#include "bench_common.hpp"
+
+/*
+ *  Loading a file: read() into a heap shared_buf vs xu::map_file, with and without
+ *  MAP_POPULATE. "first touch" includes summing one byte per page of the result
+ *  Usage: bench_mmap [MiB]
+ */
+
+static uint64_t touchPages(const xu::shared_buf& buf)
+{
+  uint64_t sum = 0;
+  for (size_t i = 0; i < buf.size(); i += 4096)
+  {
+    sum += buf.data()[i];
+  }
+  return sum;
+}
+
+int main(int argc, char** argv)
+{
+  size_t mib = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 256;
+  size_t sz = mib << 20;
+
+  char path[] = "/tmp/bench_shared_buf_mmap_XXXXXX";
+  int fd = ::mkstemp(path);
+  if (fd < 0)
+  {
+    std::perror("mkstemp");
+    return 1;
+  }
+
+  {
+    xu::shared_buf chunk = xu::make_shared_buf(1 << 20);
+    for (size_t i = 0; i < chunk.size(); i++)
+    {
+      chunk[i] = (uint8_t)i;
+    }
+    std::vector<xu::shared_buf> chunks(mib, chunk);
+    xu::write_to(fd, chunks);
+  }
+
+  std::printf("file=%zu MiB\n", mib);
+
+  bench::runBytes("  read() into shared_buf + first touch", 5, sz, [&](size_t)
+  {
+    int rfd = ::open(path, O_RDONLY);
+    xu::shared_buf buf = xu::make_shared_buf(sz);
+    xu::read_from(rfd, buf);
+    ::close(rfd);
+    bench::doNotOptimize(touchPages(buf));
+  });
+
+  bench::runBytes("  map_file() + first touch", 5, sz, [&](size_t)
+  {
+    xu::shared_buf buf = xu::map_file(path);
+    bench::doNotOptimize(touchPages(buf));
+  });
+
+  bench::runBytes("  map_file(populate) + first touch", 5, sz, [&](size_t)
+  {
+    xu::map_options opts;
+    opts.populate = true;
+    xu::shared_buf buf = xu::map_file(path, opts);
+    bench::doNotOptimize(touchPages(buf));
+  });
+
+  bench::run("  map_file() only (startup cost)", 100, [&](size_t)
+  {
+    xu::shared_buf buf = xu::map_file(path);
+    bench::doNotOptimize(buf.data());
+  });
+
+  ::close(fd);
+  ::unlink(path);
+}
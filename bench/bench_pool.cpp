@@ -0,0 +1,97 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2020 Kevin Xu
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+#include "shared_buf_pool.hpp"
+
+/*
+ *  Multi-threaded alloc/free throughput: system allocator vs buf_pool
+ *  Each thread keeps a small window of live buffers so that frees interleave with allocations
+ */
+
+template<typename Make>
+static void runThreads(const char* name, size_t num_threads, size_t iterations, Make&& make)
+{
+  auto start = std::chrono::steady_clock::now();
+
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < num_threads; t++)
+  {
+    threads.emplace_back([&, t]()
+    {
+      std::vector<xu::shared_buf> window(16, xu::shared_buf(0));
+      for (size_t i = 0; i < iterations; i++)
+      {
+        size_t sz = size_t(64) << ((i + t) % 11);
+        window[i % window.size()] = make(sz);
+      }
+    });
+  }
+  for (auto& th : threads)
+  {
+    th.join();
+  }
+
+  auto stop = std::chrono::steady_clock::now();
+  double secs = std::chrono::duration<double>(stop - start).count();
+
+  std::printf("%-32s threads=%-3zu %10.2f Mops/s\n", name, num_threads,
+    num_threads * iterations / secs / 1e6);
+}
+
+int main()
+{
+  const size_t iterations = 500000;
+  const size_t thread_counts[] = {1, 2, 4, 8};
+
+  xu::buf_pool pool;
+
+  for (size_t n : thread_counts)
+  {
+    runThreads("shared_buf(sz)", n, iterations, [](size_t sz)
+    {
+      return xu::shared_buf(sz);
+    });
+
+    runThreads("make_shared_buf(sz)", n, iterations, [](size_t sz)
+    {
+      return xu::make_shared_buf(sz);
+    });
+
+    runThreads("make_shared_buf(sz, pool)", n, iterations, [&pool](size_t sz)
+    {
+      return xu::make_shared_buf(sz, pool);
+    });
+  }
+
+  xu::buf_pool::stats st = pool.getStats();
+  std::printf("pool: allocations=%llu cache_hits=%llu depot_hits=%llu system_allocations=%llu\n",
+    (unsigned long long)st.allocations,
+    (unsigned long long)st.cache_hits,
+    (unsigned long long)st.depot_hits,
+    (unsigned long long)st.system_allocations);
+}
@@ -0,0 +1,164 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2020 Kevin Xu
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include "shared_buf_queue.hpp"
+#include "bench_common.hpp"
+
+/*
+ *  N producer and N consumer threads pass pre-allocated buffers through a queue:
+ *  std::mutex + std::queue<shared_buf>, vs buf_queue one at a time and in batches of 16
+ *  Usage: bench_queue [max threads]
+ */
+
+static const size_t total = 2000000;
+static const size_t batch = 16;
+
+struct mutex_queue
+{
+  std::mutex mutex;
+  std::queue<xu::shared_buf> queue;
+
+  bool tryPush(xu::shared_buf&& buf)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    queue.push(std::move(buf));
+    return true;
+  }
+
+  bool tryPop(xu::shared_buf& buf)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (queue.empty())
+    {
+      return false;
+    }
+    buf = std::move(queue.front());
+    queue.pop();
+    return true;
+  }
+};
+
+/**
+  @brief  Runs pairs producer/consumer pairs; push(bufs, n) and pop(bufs, n) move up to n
+          buffers and return how many they moved
+  */
+template<typename Push_T, typename Pop_T>
+static void run(const char* name, size_t pairs, const xu::shared_buf& msg, Push_T&& push, Pop_T&& pop)
+{
+  size_t per_producer = total / pairs;
+  std::atomic<size_t> received{0};
+  std::vector<std::thread> threads;
+
+  auto start = std::chrono::steady_clock::now();
+  for (size_t t = 0; t < pairs; t++)
+  {
+    threads.emplace_back([&]()
+    {
+      std::vector<xu::shared_buf> bufs(batch, msg);
+      for (size_t sent = 0; sent < per_producer; )
+      {
+        size_t n = push(bufs.data(), std::min(batch, per_producer - sent));
+        for (size_t i = 0; i < n; i++)
+        {
+          bufs[i] = msg;
+        }
+        sent += n;
+        if (n == 0)
+        {
+          std::this_thread::yield();
+        }
+      }
+    });
+    threads.emplace_back([&]()
+    {
+      std::vector<xu::shared_buf> bufs(batch, xu::shared_buf(0, nullptr));
+      while (received.load(std::memory_order_relaxed) < per_producer * pairs)
+      {
+        size_t n = pop(bufs.data(), batch);
+        received.fetch_add(n, std::memory_order_relaxed);
+        if (n == 0)
+        {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (auto& th : threads)
+  {
+    th.join();
+  }
+  auto stop = std::chrono::steady_clock::now();
+
+  double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+  std::printf("  %-28s threads=%-3zu %8.2f ns/msg %8.2f M msg/s\n", name, 2 * pairs,
+    ns / (per_producer * pairs), (per_producer * pairs) / ns * 1000);
+}
+
+int main(int argc, char** argv)
+{
+  size_t max_threads = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 64;
+  xu::shared_buf msg = xu::make_shared_buf(64);
+
+  for (size_t threads = 2; threads <= max_threads; threads *= 2)
+  {
+    size_t pairs = threads / 2;
+
+    mutex_queue locked;
+    run("mutex + std::queue", pairs, msg, [&](xu::shared_buf* bufs, size_t)
+    {
+      return (size_t)locked.tryPush(std::move(bufs[0]));
+    }, [&](xu::shared_buf* bufs, size_t)
+    {
+      return (size_t)locked.tryPop(bufs[0]);
+    });
+
+    xu::buf_queue single(4096);
+    run("buf_queue", pairs, msg, [&](xu::shared_buf* bufs, size_t)
+    {
+      return (size_t)single.tryPush(std::move(bufs[0]));
+    }, [&](xu::shared_buf* bufs, size_t)
+    {
+      return (size_t)single.tryPop(bufs[0]);
+    });
+
+    xu::buf_queue batched(4096);
+    run("buf_queue, batches of 16", pairs, msg, [&](xu::shared_buf* bufs, size_t n)
+    {
+      return batched.tryPushBatch(bufs, n);
+    }, [&](xu::shared_buf* bufs, size_t n)
+    {
+      return batched.tryPopBatch(bufs, n);
+    });
+  }
+}
@@ -0,0 +1,107 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2020 Kevin Xu
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "shared_buf_pool.hpp"
+#include "shared_buf_recycle.hpp"
+#include "bench_common.hpp"
+
+/*
+ *  A receive path of 9 KiB jumbo frames: allocate a frame, fill it, checksum it, and keep it
+ *  in a small window of in-flight frames before dropping it. Compares the system allocator,
+ *  buf_pool and recycling_pool, whose LIFO reuse hands back the most recently freed frame
+ */
+
+template<typename Make_T>
+static void benchFrames(const char* name, size_t window_sz, Make_T&& make)
+{
+  const size_t frame_sz = 9216;
+  const size_t iterations = 500000;
+  std::vector<xu::shared_buf> window(window_sz, xu::shared_buf(0, nullptr));
+  uint64_t sum = 0;
+
+  char label[96];
+  std::snprintf(label, sizeof(label), "  %s, %zu in flight", name, window_sz);
+  bench::runBytes(label, iterations, frame_sz, [&](size_t i)
+  {
+    xu::shared_buf frame = make(frame_sz);
+    std::memset(frame.data(), (int)i, frame_sz);
+    for (size_t j = 0; j < frame_sz; j += 64)
+    {
+      sum += frame.data()[j];
+    }
+    window[i % window_sz] = std::move(frame);
+  });
+  bench::doNotOptimize(sum);
+}
+
+int main()
+{
+  const size_t windows[] = {1, 16, 256};
+
+  xu::buf_pool pool;
+  xu::recycling_pool recycler;
+
+  for (size_t window_sz : windows)
+  {
+    benchFrames("make_shared_buf", window_sz, [](size_t sz)
+    {
+      return xu::make_shared_buf(sz);
+    });
+
+    benchFrames("buf_pool", window_sz, [&](size_t sz)
+    {
+      return pool.make(sz);
+    });
+
+    benchFrames("recycling_pool", window_sz, [&](size_t sz)
+    {
+      return recycler.make(sz);
+    });
+  }
+
+  /* allocation cost alone: make a frame and drop it, without touching the bytes */
+  const size_t iterations = 5000000;
+  bench::run("make and drop, make_shared_buf", iterations, [&](size_t)
+  {
+    xu::shared_buf frame = xu::make_shared_buf(9216);
+    bench::doNotOptimize(frame.data());
+  });
+  bench::run("make and drop, buf_pool", iterations, [&](size_t)
+  {
+    xu::shared_buf frame = pool.make(9216);
+    bench::doNotOptimize(frame.data());
+  });
+  bench::run("make and drop, recycling_pool", iterations, [&](size_t)
+  {
+    xu::shared_buf frame = recycler.make(9216);
+    bench::doNotOptimize(frame.data());
+  });
+
+  xu::recycling_pool::stats st = recycler.getStats();
+  std::printf("recycling_pool: hit rate %.4f, %zu KiB pooled\n", st.hitRate(), st.pooled_bytes >> 10);
+}
@@ -0,0 +1,172 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2020 Kevin Xu
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include "shared_buf_ring.hpp"
+#include "bench_common.hpp"
+
+/*
+ *  Moving bytes from a reader thread to a parser thread in fixed-size messages: a mutex-
+ *  protected std::deque<shared_buf> of freshly allocated messages, vs spsc_ring with a commit
+ *  per message or per batch of 16, and the mirrored ring
+ */
+
+static const size_t total = size_t(1) << 30;
+
+template<typename Fn>
+static void report(const char* name, size_t msg_sz, Fn&& fn)
+{
+  auto start = std::chrono::steady_clock::now();
+  fn();
+  auto stop = std::chrono::steady_clock::now();
+  double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+  std::printf("  %-36s %8.2f ns/msg %8.2f GB/s\n", name, ns / (total / msg_sz), total / ns);
+}
+
+static void benchDeque(size_t msg_sz)
+{
+  std::mutex mutex;
+  std::deque<xu::shared_buf> queue;
+
+  std::thread producer([&]()
+  {
+    for (size_t sent = 0; sent < total; sent += msg_sz)
+    {
+      xu::shared_buf msg = xu::make_shared_buf(msg_sz);
+      std::memset(msg.data(), (int)sent, msg_sz);
+      std::lock_guard<std::mutex> lock(mutex);
+      queue.push_back(std::move(msg));
+    }
+  });
+
+  uint64_t sum = 0;
+  for (size_t received = 0; received < total; )
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (queue.empty())
+    {
+      lock.unlock();
+      std::this_thread::yield();
+      continue;
+    }
+    xu::shared_buf msg = std::move(queue.front());
+    queue.pop_front();
+    lock.unlock();
+
+    sum += msg.data()[0];
+    received += msg.size();
+  }
+  producer.join();
+  bench::doNotOptimize(sum);
+}
+
+static void benchRing(xu::spsc_ring& ring, size_t msg_sz, size_t batch)
+{
+  std::thread producer([&]()
+  {
+    size_t pending = 0;
+    for (size_t sent = 0; sent < total; )
+    {
+      uint8_t* msg = ring.prepare(msg_sz);
+      if (msg == nullptr)
+      {
+        ring.commit();
+        pending = 0;
+        std::this_thread::yield();
+        continue;
+      }
+      std::memset(msg, (int)sent, msg_sz);
+      sent += msg_sz;
+      if (++pending == batch)
+      {
+        ring.commit();
+        pending = 0;
+      }
+    }
+    ring.commit();
+  });
+
+  uint64_t sum = 0;
+  size_t pending = 0;
+  for (size_t received = 0; received < total; )
+  {
+    xu::shared_buf msg = ring.read(msg_sz);
+    if (msg.size() == 0)
+    {
+      ring.release();
+      pending = 0;
+      std::this_thread::yield();
+      continue;
+    }
+    sum += msg.data()[0];
+    received += msg.size();
+    if (++pending == batch)
+    {
+      ring.release();
+      pending = 0;
+    }
+  }
+  ring.release();
+  producer.join();
+  bench::doNotOptimize(sum);
+}
+
+int main()
+{
+  const size_t msg_sizes[] = {64, 256, 4096};
+
+  for (size_t msg_sz : msg_sizes)
+  {
+    std::printf("message=%zu B\n", msg_sz);
+
+    report("mutex + deque<shared_buf>", msg_sz, [&]()
+    {
+      benchDeque(msg_sz);
+    });
+
+    xu::spsc_ring ring(size_t(1) << 20);
+    report("spsc_ring, commit each", msg_sz, [&]()
+    {
+      benchRing(ring, msg_sz, 1);
+    });
+
+    xu::spsc_ring batched(size_t(1) << 20);
+    report("spsc_ring, commit per 16", msg_sz, [&]()
+    {
+      benchRing(batched, msg_sz, 16);
+    });
+
+    xu::spsc_ring mirrored(size_t(1) << 20, true);
+    report("spsc_ring mirrored, commit per 16", msg_sz, [&]()
+    {
+      benchRing(mirrored, msg_sz, 16);
+    });
+  }
+}
@@ -0,0 +1,96 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2020 Kevin Xu
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+#include "shared_buf_snapshot.hpp"
+#include "bench_common.hpp"
+
+/*
+ *  Snapshot + sparse write: copy a filled buffer, then write one byte in every 100th page of
+ *  the original. Compares deepCopy() of a heap buffer with one from make_snapshot_buf(), in
+ *  time and in memory added (AnonPages + Shmem from /proc/meminfo, since remapping moves
+ *  pages in and out of this process's RSS without allocating or freeing them)
+ *  Usage: bench_snapshot [MiB]
+ */
+
+static long memoryKiB()
+{
+  std::ifstream meminfo("/proc/meminfo");
+  std::string line;
+  long total = 0;
+  while (std::getline(meminfo, line))
+  {
+    if (line.rfind("AnonPages:", 0) == 0 or line.rfind("Shmem:", 0) == 0)
+    {
+      total += std::strtol(line.c_str() + line.find(':') + 1, nullptr, 10);
+    }
+  }
+  return total;
+}
+
+static double msSince(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void benchSnapshot(const char* label, xu::shared_buf buf)
+{
+  const size_t page = 4096;
+  std::memset(buf.data(), 1, buf.size());
+  long before = memoryKiB();
+
+  for (int round = 1; round <= 2; round++)
+  {
+    auto start = std::chrono::steady_clock::now();
+    xu::shared_buf snapshot = buf.deepCopy();
+    double copy_ms = msSince(start);
+
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < buf.size(); i += 100 * page)
+    {
+      buf[i]++;
+    }
+    double write_ms = msSince(start);
+
+    bench::doNotOptimize(snapshot.data()[0]);
+    std::printf("%-28s snapshot %d: deepCopy %8.2f ms, sparse write %6.2f ms, +%7.1f MiB\n",
+      label, round, copy_ms, write_ms, (double)(memoryKiB() - before) / 1024);
+  }
+}
+
+int main(int argc, char** argv)
+{
+  size_t mib = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1024;
+  size_t sz = mib << 20;
+
+  std::printf("buffer=%zu MiB\n", mib);
+  benchSnapshot("make_shared_buf", xu::make_shared_buf(sz));
+  benchSnapshot("make_snapshot_buf", xu::make_snapshot_buf(sz));
+}
@@ -0,0 +1,111 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2020 Kevin Xu
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "shared_buf_view.hpp"
+#include "bench_common.hpp"
+
+/*
+ *  Several threads pass the same buffer into a helper that does not retain it
+ *  By value, every call bumps the shared refcount twice, bouncing its cache line between
+ *  cores; by view, the control block is never touched
+ */
+
+__attribute__((noinline)) static uint8_t firstByValue(xu::shared_buf buf)
+{
+  asm volatile("" : : : "memory");
+  return buf.data()[0];
+}
+
+__attribute__((noinline)) static uint8_t firstByRef(const xu::shared_buf& buf)
+{
+  asm volatile("" : : : "memory");
+  return buf.data()[0];
+}
+
+__attribute__((noinline)) static uint8_t firstByView(xu::shared_buf_view view)
+{
+  asm volatile("" : : : "memory");
+  return view.data()[0];
+}
+
+template<typename Fn>
+static void runThreads(const char* name, size_t num_threads, size_t iterations, Fn&& fn)
+{
+  auto start = std::chrono::steady_clock::now();
+
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < num_threads; t++)
+  {
+    threads.emplace_back([&]()
+    {
+      unsigned sum = 0;
+      for (size_t i = 0; i < iterations; i++)
+      {
+        sum += fn();
+      }
+      bench::doNotOptimize(sum);
+    });
+  }
+  for (auto& th : threads)
+  {
+    th.join();
+  }
+
+  auto stop = std::chrono::steady_clock::now();
+  double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+
+  std::printf("%-28s threads=%-3zu %8.2f ns/call\n", name, num_threads, ns / iterations);
+}
+
+int main()
+{
+  const size_t iterations = 5000000;
+  const size_t thread_counts[] = {1, 2, 4, 8};
+
+  xu::shared_buf buf = xu::make_shared_buf(64);
+  buf[0] = 1;
+
+  for (size_t n : thread_counts)
+  {
+    runThreads("shared_buf by value", n, iterations, [&]()
+    {
+      return firstByValue(buf);
+    });
+
+    runThreads("const shared_buf&", n, iterations, [&]()
+    {
+      return firstByRef(buf);
+    });
+
+    runThreads("shared_buf_view", n, iterations, [&]()
+    {
+      return firstByView(buf);
+    });
+  }
+}
@@ -0,0 +1,93 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2020 Kevin Xu
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+#include "shared_buf.hpp"
+#include "bench_common.hpp"
+
+/*
+ *  Allocating a large zeroed buffer of which only every 64th page is then written:
+ *  make_shared_buf + memset vs shared_buf::zeroed, in time and in resident memory
+ *  Usage: bench_zeroed [MiB]
+ */
+
+static long rssKiB()
+{
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line))
+  {
+    if (line.rfind("VmRSS:", 0) == 0)
+    {
+      return std::strtol(line.c_str() + 6, nullptr, 10);
+    }
+  }
+  return 0;
+}
+
+template<typename Make_T>
+static void benchZeroed(const char* name, size_t sz, Make_T&& make)
+{
+  const size_t page = 4096;
+  long before = rssKiB();
+
+  auto start = std::chrono::steady_clock::now();
+  xu::shared_buf buf = make(sz);
+  for (size_t i = 0; i < sz; i += 64 * page)
+  {
+    buf.data()[i] = 1;
+  }
+  auto stop = std::chrono::steady_clock::now();
+
+  bench::doNotOptimize(buf.data()[0]);
+  std::printf("  %-32s %8.2f ms, +%7.1f MiB resident\n", name,
+    std::chrono::duration<double, std::milli>(stop - start).count(),
+    (double)(rssKiB() - before) / 1024);
+}
+
+int main(int argc, char** argv)
+{
+  size_t mib = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1024;
+  size_t sz = mib << 20;
+
+  std::printf("buffer=%zu MiB, 1 in 64 pages written\n", mib);
+
+  benchZeroed("make_shared_buf + memset", sz, [](size_t n)
+  {
+    xu::shared_buf buf = xu::make_shared_buf(n);
+    std::memset(buf.data(), 0, n);
+    return buf;
+  });
+
+  benchZeroed("shared_buf::zeroed", sz, [](size_t n)
+  {
+    return xu::shared_buf::zeroed(n);
+  });
+}
@@ -0,0 +1,294 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2020 Kevin Xu
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <stdexcept>
+#include <utility>
+
+#include "shared_buf.hpp"
+#include "shared_buf_view.hpp"
+
+namespace xu
+{
+  /**
+    @brief  Implements a copy-on-write buffer
+            Copies share the bytes like shared_buf, but mutable access (non-const
+            operator[], at(), begin(), end() and data()) first detaches into a private
+            deep copy if the bytes are shared; const access never copies
+    @note   Pointers and iterators obtained through mutable access must not be written
+            through once the buffer has been copied again, since the copy shares them
+    @note   On a non-const cow_buf, reading through the mutable accessors also detaches;
+            read through a const reference, cbegin()/cend() or shared_buf_view instead
+    @note   Thread safety is that of shared_buf: distinct cow_bufs sharing bytes may be used
+            from different threads, but one cow_buf must not be used concurrently. Bytes
+            read-only mapped (map_file() without writable) or in shared memory are never
+            written in place; the first mutable access always copies them
+    */
+  class cow_buf
+  {
+  public:
+    //  =========
+    //  Iterators
+    //  =========
+
+    using iterator = shared_buf::iterator;
+    using const_iterator = shared_buf::const_iterator;
+    using reverse_iterator = shared_buf::reverse_iterator;
+    using const_reverse_iterator = shared_buf::const_reverse_iterator;
+
+    iterator begin()
+    {
+      detach();
+      return buf.begin();
+    }
+
+    iterator end()
+    {
+      detach();
+      return buf.end();
+    }
+
+    const_iterator begin() const
+    {
+      return std::as_const(buf).begin();
+    }
+
+    const_iterator end() const
+    {
+      return std::as_const(buf).end();
+    }
+
+    const_iterator cbegin() const
+    {
+      return begin();
+    }
+
+    const_iterator cend() const
+    {
+      return end();
+    }
+
+    reverse_iterator rbegin()
+    {
+      return reverse_iterator(end());
+    }
+
+    reverse_iterator rend()
+    {
+      return reverse_iterator(begin());
+    }
+
+    const_reverse_iterator rbegin() const
+    {
+      return const_reverse_iterator(end());
+    }
+
+    const_reverse_iterator rend() const
+    {
+      return const_reverse_iterator(begin());
+    }
+
+    //  ================
+    //  Member Functions
+    //  ================
+
+    /**
+      @brief  Constructor
+      @param  sz
+              Number of bytes in buffer
+      @note   Bytes are left uninitialized, as with make_shared_buf(size_t)
+      */
+    explicit cow_buf(size_t sz)
+      : buf(make_shared_buf(sz)),
+        writable(true)
+    {
+
+    }
+
+    /**
+      @brief  Constructor, shares the bytes of a shared buffer (or a slice of one)
+              The first mutable access copies them, unless buf_ was the last reference
+      */
+    explicit cow_buf(shared_buf buf_)
+      : buf(std::move(buf_)),
+        writable(writableInPlace(buf))
+    {
+
+    }
+
+    /**
+      @brief  Byte access, detaches first if the bytes are shared
+      @param  i
+              Index
+      @throw  std::out_of_range
+              If index is not within size, unless XU_SHARED_BUF_CHECK selects a
+              policy without exceptions
+      */
+    uint8_t& operator[](size_t i)
+    {
+      detach();
+      return buf[i];
+    }
+
+    /**
+      @brief  Byte access, const-qualified, never copies
+      @see    operator[](size_t)
+      */
+    const uint8_t& operator[](size_t i) const
+    {
+      return buf[i];
+    }
+
+    /**
+      @brief  Byte access, checked under every policy, detaches first if the bytes are shared
+      @throw  std::out_of_range
+              If index is not within size
+      */
+    uint8_t& at(size_t i)
+    {
+      if (i >= buf.size())
+      {
+        throw std::out_of_range("cow_buf::at() : index out of range");
+      }
+      detach();
+      return buf[i];
+    }
+
+    /**
+      @brief  Byte access, checked under every policy, const-qualified
+      @throw  std::out_of_range
+              If index is not within size
+      */
+    const uint8_t& at(size_t i) const
+    {
+      return buf.at(i);
+    }
+
+    /**
+      @brief  Pointer access, detaches first if the bytes are shared
+      */
+    uint8_t* data()
+    {
+      detach();
+      return buf.data();
+    }
+
+    /**
+      @brief  Pointer access, const-qualified, never copies
+      */
+    const uint8_t* data() const
+    {
+      return buf.data();
+    }
+
+    /**
+      @brief  Returns a read-only view of the bytes
+      */
+    operator shared_buf_view() const
+    {
+      return buf;
+    }
+
+    /**
+      @brief  Gives this buffer private bytes, copying them if they are shared
+      */
+    void detach()
+    {
+      if (not writable or buf.use_count() > 1)
+      {
+        buf = buf.deepCopy();
+        writable = true;
+      }
+      else
+      {
+        /*
+         *  use_count() is a relaxed load: order the reads other threads made before
+         *  dropping their references ahead of our writes, as their release decrement
+         *  allows
+         */
+        std::atomic_thread_fence(std::memory_order_acquire);
+      }
+    }
+
+    /**
+      @brief  Output to string
+      @param  fmt
+              Hex layout, [01,02,...] by default
+      */
+    std::ostream& print(std::ostream& stream, const hex_format& fmt = hex_format()) const
+    {
+      return buf.print(stream, fmt);
+    }
+
+    /**
+      @brief  Returns size
+      */
+    size_t size() const
+    {
+      return buf.size();
+    }
+
+    /**
+      @brief  Returns the number of buffers sharing the bytes
+      @see    shared_buf::use_count()
+      */
+    long use_count() const
+    {
+      return buf.use_count();
+    }
+
+  protected:
+    /**
+      @brief  Returns false for bytes that must not be written even when unshared: read-only
+              mappings, and shared memory, whose writes other processes would see
+      */
+    static bool writableInPlace(const shared_buf& bytes)
+    {
+#if XU_SHARED_BUF_HAS_MMAP
+      if (const detail::munmap_deleter* mapping = bytes.getDeleter<detail::munmap_deleter>())
+      {
+        return not mapping->read_only;
+      }
+#endif
+      return bytes.getDeleter<detail::shm_deleter>() == nullptr;
+    }
+
+    //  ================
+    //  Member Variables
+    //  ================
+
+    shared_buf buf;
+    /* false until detach() has copied bytes that must not be written in place */
+    bool writable;
+  };
+}
+
+inline std::ostream& operator<<(std::ostream& stream, const xu::cow_buf& buf)
+{
+  return buf.print(stream);
+}
@@ -24,14 +24,177 @@
 
 #pragma once
 
+#include <cassert>
+#include <cstddef>
 #include <cstdint>
-#include <iomanip>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
 #include <memory>
+#include <new>
 #include <ostream>
 #include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#if __has_include(<sys/mman.h>)
+#include <sys/mman.h>
+#define XU_SHARED_BUF_HAS_MMAP 1
+#else
+#define XU_SHARED_BUF_HAS_MMAP 0
+#endif
+
+#include "shared_buf_base64.hpp"
+#include "shared_buf_copy.hpp"
+#include "shared_buf_hex.hpp"
+
+/*
+ *  Checking policy for shared_buf::operator[] and other accessors; at() is always checked
+ *    XU_SHARED_BUF_CHECK_NONE      no checks
+ *    XU_SHARED_BUF_CHECK_ASSERT    assert() on out-of-range indices
+ *    XU_SHARED_BUF_CHECK_THROW     throw std::out_of_range on out-of-range indices (default)
+ *    XU_SHARED_BUF_CHECK_HARDENED  as THROW, and also throw std::logic_error on any access
+ *                                  to a moved-from buffer
+ */
+#define XU_SHARED_BUF_CHECK_NONE 0
+#define XU_SHARED_BUF_CHECK_ASSERT 1
+#define XU_SHARED_BUF_CHECK_THROW 2
+#define XU_SHARED_BUF_CHECK_HARDENED 3
+
+#ifndef XU_SHARED_BUF_CHECK
+#define XU_SHARED_BUF_CHECK XU_SHARED_BUF_CHECK_THROW
+#endif
+
+/*
+ *  If nonzero, shared_buf::iterator and const_iterator are the bounds-checked iterator_;
+ *  otherwise they are the pointer-sized contiguous_iterator_, which standard algorithms can
+ *  lower to memcpy/memchr or vectorize. Defaults to checked under the hardened policy, and
+ *  otherwise unless NDEBUG is defined or checks are disabled
+ */
+#ifndef XU_SHARED_BUF_CHECKED_ITERATORS
+#if XU_SHARED_BUF_CHECK == XU_SHARED_BUF_CHECK_HARDENED
+#define XU_SHARED_BUF_CHECKED_ITERATORS 1
+#elif defined(NDEBUG) or XU_SHARED_BUF_CHECK == XU_SHARED_BUF_CHECK_NONE
+#define XU_SHARED_BUF_CHECKED_ITERATORS 0
+#else
+#define XU_SHARED_BUF_CHECKED_ITERATORS 1
+#endif
+#endif
 
 namespace xu
 {
+  class shared_buf;
+
+  shared_buf make_shared_buf(size_t sz);
+
+  namespace detail
+  {
+    /**
+      @brief  Applies the XU_SHARED_BUF_CHECK policy to an index
+      */
+    inline void checkIndex(size_t i, size_t sz, const char* what)
+    {
+#if XU_SHARED_BUF_CHECK >= XU_SHARED_BUF_CHECK_THROW
+      if (i >= sz)
+      {
+        throw std::out_of_range(what);
+      }
+#elif XU_SHARED_BUF_CHECK == XU_SHARED_BUF_CHECK_ASSERT
+      assert(i < sz and what);
+#else
+      (void)i;
+      (void)sz;
+      (void)what;
+#endif
+    }
+
+    /**
+      @brief  Under XU_SHARED_BUF_CHECK_HARDENED, rejects use of a moved-from buffer,
+              recognized by its null storage pointer
+      @throw  std::logic_error
+              If the buffer has been moved from
+      */
+    inline void checkLive(const void* storage, const char* what)
+    {
+#if XU_SHARED_BUF_CHECK == XU_SHARED_BUF_CHECK_HARDENED
+      if (storage == nullptr)
+      {
+        throw std::logic_error(what);
+      }
+#else
+      (void)storage;
+      (void)what;
+#endif
+    }
+
+    /**
+      @brief  Deleter for storage from malloc() or calloc()
+      */
+    struct free_deleter
+    {
+      void operator()(uint8_t* bytes) const
+      {
+        std::free(bytes);
+      }
+    };
+
+#if XU_SHARED_BUF_HAS_MMAP
+    /**
+      @brief  Deleter unmapping a whole mapping, given any pointer into it
+      */
+    struct munmap_deleter
+    {
+      void* base;
+      size_t len;
+      /* true if the mapping is PROT_READ only */
+      bool read_only = false;
+
+      void operator()(uint8_t*) const
+      {
+        ::munmap(base, len);
+      }
+    };
+#endif
+
+    /**
+      @brief  Deleter for buffers backed by a shared-memory object
+              Owns both the mapping and the descriptor, so that the buffer can be exported
+      @note   Defined in shared_buf_shm.hpp; declared here so that cow_buf can recognize it
+      */
+    struct shm_deleter
+    {
+      void* base;
+      size_t len;
+      int fd;
+      /* offset of base within the shared-memory object */
+      size_t file_offset;
+
+      void operator()(uint8_t*) const;
+    };
+
+    struct snapshot_file;
+
+    /**
+      @brief  Deleter for buffers made by make_snapshot_buf(), which deepCopy() recognizes
+              and hands to copy rather than copying bytes
+      @see    shared_buf_snapshot.hpp, which defines the members declared here
+      */
+    struct snapshot_deleter
+    {
+      uint8_t* base;
+      size_t len;
+      /* offset of base within the file */
+      size_t file_offset;
+      std::shared_ptr<snapshot_file> file;
+      /* true while base is a MAP_SHARED mapping, whose writes reach the file */
+      bool writes_file;
+      /* a function pointer, so that this header need not define it */
+      shared_buf (*copy)(const shared_buf& buf, snapshot_deleter& deleter);
+
+      void operator()(uint8_t*) const;
+    };
+  }
+
   /**
     @brief  Implements a shared buffer containing a known number of bytes in memory
             Wraps a smart pointer with a size and implements helpful operators and an iterator
@@ -43,6 +206,10 @@ namespace xu
     //  Iterators
     //  =========
 
+    /**
+      @brief  Bounds-checked iterator
+              Never moves outside [begin, end], and throws on dereferencing end
+      */
     template<typename Val_T>
     class iterator_
     {
@@ -51,6 +218,21 @@ namespace xu
       size_t sz;
       size_t i;
     public:
+      using iterator_category = std::bidirectional_iterator_tag;
+      using value_type = uint8_t;
+      using difference_type = std::ptrdiff_t;
+      using pointer = Val_T*;
+      using reference = Val_T&;
+
+      /**
+        @brief  Constructor, creates an iterator over no bytes, equal only to another such
+        */
+      iterator_()
+        : base_ptr(nullptr),
+          sz(0),
+          i(0)
+      {}
+
       iterator_(
         uint8_t* base_ptr_,
         size_t sz_,
@@ -95,6 +277,22 @@ namespace xu
         return res;
       }
 
+      iterator_& operator--()
+      {
+        if (i > 0)
+        {
+          i--;
+        }
+        return *this;
+      }
+
+      iterator_ operator--(int)
+      {
+        iterator_ res = *this;
+        operator--();
+        return res;
+      }
+
       iterator_& operator+=(size_t n)
       {
         size_t next = i + n;
@@ -138,6 +336,11 @@ namespace xu
         }
       }
 
+      Val_T* operator->() const
+      {
+        return ptr();
+      }
+
       Val_T* ptr() const
       {
         if (i < sz)
@@ -173,27 +376,250 @@ namespace xu
       }
     };
 
+    /**
+      @brief  Unchecked, pointer-sized iterator
+              Models a contiguous (random-access) iterator, so standard algorithms see
+              through it to the underlying bytes
+      */
+    template<typename Val_T>
+    class contiguous_iterator_
+    {
+    protected:
+      Val_T* p;
+
+      template<typename>
+      friend class contiguous_iterator_;
+
+    public:
+#if __cplusplus >= 202002L
+      using iterator_concept = std::contiguous_iterator_tag;
+#endif
+      using iterator_category = std::random_access_iterator_tag;
+      using value_type = uint8_t;
+      using element_type = Val_T;
+      using difference_type = std::ptrdiff_t;
+      using pointer = Val_T*;
+      using reference = Val_T&;
+
+      contiguous_iterator_()
+        : p(nullptr)
+      {}
+
+      explicit contiguous_iterator_(Val_T* p_)
+        : p(p_)
+      {}
+
+      Val_T& operator*() const
+      {
+        return *p;
+      }
+
+      Val_T* operator->() const
+      {
+        return p;
+      }
+
+      Val_T& operator[](difference_type n) const
+      {
+        return p[n];
+      }
+
+      Val_T* ptr() const
+      {
+        return p;
+      }
+
+      contiguous_iterator_& operator++()
+      {
+        ++p;
+        return *this;
+      }
+
+      contiguous_iterator_ operator++(int)
+      {
+        return contiguous_iterator_(p++);
+      }
+
+      contiguous_iterator_& operator--()
+      {
+        --p;
+        return *this;
+      }
+
+      contiguous_iterator_ operator--(int)
+      {
+        return contiguous_iterator_(p--);
+      }
+
+      contiguous_iterator_& operator+=(difference_type n)
+      {
+        p += n;
+        return *this;
+      }
+
+      contiguous_iterator_& operator-=(difference_type n)
+      {
+        p -= n;
+        return *this;
+      }
+
+      contiguous_iterator_ operator+(difference_type n) const
+      {
+        return contiguous_iterator_(p + n);
+      }
+
+      friend contiguous_iterator_ operator+(difference_type n, const contiguous_iterator_& it)
+      {
+        return contiguous_iterator_(it.p + n);
+      }
+
+      contiguous_iterator_ operator-(difference_type n) const
+      {
+        return contiguous_iterator_(p - n);
+      }
+
+      /**
+        @brief  Returns signed distance between two iterators, measured in bytes
+        */
+      template<typename Other_T>
+      difference_type operator-(const contiguous_iterator_<Other_T>& other) const
+      {
+        return p - other.p;
+      }
+
+      template<typename Other_T>
+      bool operator==(const contiguous_iterator_<Other_T>& other) const
+      {
+        return p == other.p;
+      }
+
+      template<typename Other_T>
+      bool operator!=(const contiguous_iterator_<Other_T>& other) const
+      {
+        return p != other.p;
+      }
+
+      template<typename Other_T>
+      bool operator<(const contiguous_iterator_<Other_T>& other) const
+      {
+        return p < other.p;
+      }
+
+      template<typename Other_T>
+      bool operator>(const contiguous_iterator_<Other_T>& other) const
+      {
+        return p > other.p;
+      }
+
+      template<typename Other_T>
+      bool operator<=(const contiguous_iterator_<Other_T>& other) const
+      {
+        return p <= other.p;
+      }
+
+      template<typename Other_T>
+      bool operator>=(const contiguous_iterator_<Other_T>& other) const
+      {
+        return p >= other.p;
+      }
+
+      operator contiguous_iterator_<const Val_T>() const
+      {
+        return contiguous_iterator_<const Val_T>(p);
+      }
+    };
+
+#if XU_SHARED_BUF_CHECKED_ITERATORS
     using iterator = iterator_<uint8_t>;
     using const_iterator = iterator_<const uint8_t>;
+#else
+    using iterator = contiguous_iterator_<uint8_t>;
+    using const_iterator = contiguous_iterator_<const uint8_t>;
+#endif
+
+    /**
+      @brief  Returns an iterator to byte i_ of [base_, base_ + sz_)
+              Lets other buffer types share shared_buf's iterators
+      */
+    static iterator makeIterator(uint8_t* base_, size_t sz_, size_t i_)
+    {
+#if XU_SHARED_BUF_CHECKED_ITERATORS
+      return iterator(base_, sz_, i_);
+#else
+      (void)sz_;
+      return iterator(base_ + i_);
+#endif
+    }
+
+    /**
+      @brief  Returns a const iterator to byte i_ of [base_, base_ + sz_)
+      */
+    static const_iterator makeIterator(const uint8_t* base_, size_t sz_, size_t i_)
+    {
+#if XU_SHARED_BUF_CHECKED_ITERATORS
+      /* checked iterators hold a non-const base pointer regardless of constness */
+      return const_iterator(const_cast<uint8_t*>(base_), sz_, i_);
+#else
+      (void)sz_;
+      return const_iterator(base_ + i_);
+#endif
+    }
 
     iterator begin()
     {
-      return iterator(&ptr[0], sz);
+      checkLive();
+      return makeIterator(ptr.get(), sz, 0);
     }
 
     iterator end()
     {
-      return iterator(&ptr[0], sz, sz);
+      checkLive();
+      return makeIterator(ptr.get(), sz, sz);
     }
 
     const_iterator begin() const
     {
-      return const_iterator(&ptr[0], sz);
+      checkLive();
+      return makeIterator((const uint8_t*)ptr.get(), sz, 0);
     }
 
     const_iterator end() const
     {
-      return const_iterator(&ptr[0], sz, sz);
+      checkLive();
+      return makeIterator((const uint8_t*)ptr.get(), sz, sz);
+    }
+
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    const_iterator cbegin() const
+    {
+      return begin();
+    }
+
+    const_iterator cend() const
+    {
+      return end();
+    }
+
+    reverse_iterator rbegin()
+    {
+      return reverse_iterator(end());
+    }
+
+    reverse_iterator rend()
+    {
+      return reverse_iterator(begin());
+    }
+
+    const_reverse_iterator rbegin() const
+    {
+      return const_reverse_iterator(end());
+    }
+
+    const_reverse_iterator rend() const
+    {
+      return const_reverse_iterator(begin());
     }
 
     //  ================
@@ -212,6 +638,41 @@ namespace xu
       
     }
 
+    /**
+      @brief  Constructor from an existing allocation
+      @param  sz_
+              Number of bytes in buffer
+      @param  ptr_
+              Pointer owning at least sz_ bytes
+      */
+    shared_buf(size_t sz_, std::shared_ptr<uint8_t[]> ptr_)
+      : sz(sz_),
+        ptr(std::move(ptr_))
+    {
+
+    }
+
+    /**
+      @brief  Constructor taking ownership of bytes, to be released by a custom deleter
+              rather than delete[], e.g. a recycler returning the storage to a free list
+      @param  sz_
+              Number of bytes in buffer
+      @param  bytes
+              First byte of storage holding at least sz_ bytes
+      @param  deleter
+              Called as deleter(bytes) when the last reference is dropped; backends can
+              recognize their buffers by it through getDeleter()
+      @note   If allocating the control block throws, deleter(bytes) is called before
+              the exception propagates
+      */
+    template<typename Deleter_T>
+    shared_buf(size_t sz_, uint8_t* bytes, Deleter_T deleter)
+      : sz(sz_),
+        ptr(bytes, std::move(deleter))
+    {
+
+    }
+
     /**
       @brief  Copy constructor
       */
@@ -262,18 +723,13 @@ namespace xu
       @param  i
               Index
       @throw  std::out_of_range
-              If index is not within size
+              If index is not within size, unless XU_SHARED_BUF_CHECK selects a
+              policy without exceptions
       */
     uint8_t& operator[](size_t i)
     {
-      if (i < sz)
-      {
-        return ptr[i];
-      }
-      else
-      {
-        throw std::out_of_range("shared_buf::operator[] : index out of range");
-      }
+      checkIndex(i, "shared_buf::operator[] : index out of range");
+      return ptr[i];
     }
 
     /**
@@ -281,18 +737,45 @@ namespace xu
       @param  i
               Index
       @throw  std::out_of_range
-              If index is not within size
+              If index is not within size, unless XU_SHARED_BUF_CHECK selects a
+              policy without exceptions
       */
     const uint8_t& operator[](size_t i) const
     {
-      if (i < sz)
+      checkIndex(i, "shared_buf::operator[] : index out of range");
+      return ptr[i];
+    }
+
+    /**
+      @brief  Byte access, checked under every policy
+      @param  i
+              Index
+      @throw  std::out_of_range
+              If index is not within size
+      */
+    uint8_t& at(size_t i)
+    {
+      if (i >= sz)
       {
-        return ptr[i];
+        throw std::out_of_range("shared_buf::at() : index out of range");
       }
-      else
+      return ptr[i];
+    }
+
+    /**
+      @brief  Byte access, checked under every policy, const-qualified
+      @param  i
+              Index
+      @throw  std::out_of_range
+              If index is not within size
+      */
+    const uint8_t& at(size_t i) const
+    {
+      if (i >= sz)
       {
-        throw std::out_of_range("shared_buf::operator[] : index out of range");
+        throw std::out_of_range("shared_buf::at() : index out of range");
       }
+      return ptr[i];
     }
 
     /**
@@ -300,6 +783,7 @@ namespace xu
       */
     uint8_t* data()
     {
+      checkLive();
       return ptr.get();
     }
 
@@ -308,47 +792,172 @@ namespace xu
       */
     const uint8_t* data() const
     {
+      checkLive();
       return ptr.get();
     }
 
+    /**
+      @brief  Returns a buffer viewing a window of this one
+              The window shares ownership of the underlying allocation, so it keeps
+              the allocation alive even if this buffer is destroyed
+      @param  offset
+              Index of the first byte in the window
+      @param  length
+              Number of bytes in the window
+      @throw  std::out_of_range
+              If the window does not lie within size
+      */
+    shared_buf slice(size_t offset, size_t length) const
+    {
+      checkLive();
+      if (offset > sz or length > sz - offset)
+      {
+        throw std::out_of_range("shared_buf::slice() : window out of range");
+      }
+
+      return shared_buf(length, std::shared_ptr<uint8_t[]>(ptr, ptr.get() + offset));
+    }
+
+    /**
+      @brief  Returns a buffer viewing the bytes from offset to the end of this one
+      @throw  std::out_of_range
+              If offset is greater than size
+      */
+    shared_buf slice(size_t offset) const
+    {
+      if (offset > sz)
+      {
+        throw std::out_of_range("shared_buf::slice() : window out of range");
+      }
+
+      return slice(offset, sz - offset);
+    }
+
     /**
       @brief  Deep copy
+      @param  opts
+              Copy engine tuning, e.g. to copy very large buffers with several threads
+      @note   Buffers from make_snapshot_buf() are copied by mapping their pages
+              copy-on-write instead, and ignore opts
+      @see    copy_bytes()
       */
-    shared_buf deepCopy() const
+    shared_buf deepCopy(const copy_options& opts = copy_options()) const
     {
-      shared_buf copy(sz);
-      for (size_t i = 0; i < sz; i++)
+      checkLive();
+      if (detail::snapshot_deleter* snapshot = getDeleter<detail::snapshot_deleter>())
       {
-        copy.ptr[i] = ptr[i];
+        return snapshot->copy(*this, *snapshot);
       }
-      return std::move(copy);
+
+      shared_buf copy = make_shared_buf(sz);
+      copy_bytes(copy.ptr.get(), ptr.get(), sz, opts);
+      return copy;
     }
 
     /**
       @brief  Output to string
+      @param  fmt
+              Hex layout, [01,02,...] by default
       */
-    std::ostream& print(std::ostream& stream) const
+    std::ostream& print(std::ostream& stream, const hex_format& fmt = hex_format()) const
     {
-      std::ios_base::fmtflags orig_stream_flags(stream.flags());
-      stream << std::resetiosflags(orig_stream_flags);
+      checkLive();
+      return print_hex(stream, ptr.get(), sz, fmt);
+    }
 
-      stream << '[' << std::hex;
+    /**
+      @brief  Returns the bytes as a hex string
+      @param  fmt
+              Hex layout, [01,02,...] by default
+      */
+    std::string toHex(const hex_format& fmt = hex_format()) const
+    {
+      checkLive();
+      return to_hex(ptr.get(), sz, fmt);
+    }
 
-      for (size_t i = 0; i < sz; i++)
+    /**
+      @brief  Returns the bytes as a padded Base64 string
+      */
+    std::string toBase64() const
+    {
+      checkLive();
+      return to_base64(ptr.get(), sz);
+    }
+
+    /* size from which zeroed() maps fresh pages rather than clearing allocated ones */
+    static constexpr size_t zeroed_map_threshold = size_t(128) << 10;
+
+    /**
+      @brief  Creates a buffer of zero bytes
+              From zeroed_map_threshold on, the bytes are fresh anonymous pages (or calloc()
+              where mmap is unavailable), which the kernel zeroes lazily on first touch, so
+              pages that are never written cost neither time nor memory
+      @param  sz
+              Number of bytes in buffer
+      @throw  std::bad_alloc
+              If the storage cannot be allocated
+      */
+    static shared_buf zeroed(size_t sz)
+    {
+      if (sz >= zeroed_map_threshold)
       {
-        if (i != 0)
+#if XU_SHARED_BUF_HAS_MMAP
+        void* base = ::mmap(nullptr, sz, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (base != MAP_FAILED)
         {
-          stream << ',';
+          return shared_buf(sz, (uint8_t*)base, detail::munmap_deleter{base, sz});
         }
-
-        stream << std::setw(2) << std::setfill('0') << (int)ptr[i];// << 'h';
+#endif
+        void* bytes = std::calloc(sz, 1);
+        if (bytes == nullptr)
+        {
+          throw std::bad_alloc();
+        }
+        return shared_buf(sz, (uint8_t*)bytes, detail::free_deleter());
       }
 
-      stream << ']';
+      shared_buf buf = make_shared_buf(sz);
+      std::memset(buf.ptr.get(), 0, sz);
+      return buf;
+    }
 
-      stream.flags(orig_stream_flags);
+    /**
+      @brief  Creates a buffer whose bytes are left uninitialized, in a single allocation
+      @see    make_shared_buf(size_t)
+      */
+    static shared_buf uninitialized(size_t sz)
+    {
+      return make_shared_buf(sz);
+    }
 
-      return stream;
+    /**
+      @brief  Creates a buffer from compact hex, e.g. "0102ff"
+      @throw  decode_error
+              If the length is odd or a character is not a hex digit
+      */
+    static shared_buf fromHex(std::string_view hex)
+    {
+      if (hex.size() % 2 != 0)
+      {
+        throw decode_error("shared_buf::fromHex() : odd number of hex digits", hex.size());
+      }
+
+      shared_buf buf = make_shared_buf(hex.size() / 2);
+      decode_hex(buf.ptr.get(), hex.data(), hex.size());
+      return buf;
+    }
+
+    /**
+      @brief  Creates a buffer from padded Base64
+      @throw  decode_error
+              If the input is malformed
+      */
+    static shared_buf fromBase64(std::string_view b64)
+    {
+      shared_buf buf = make_shared_buf(base64_decoded_length(b64.data(), b64.size()));
+      decode_base64(buf.ptr.get(), b64.data(), b64.size());
+      return buf;
     }
 
     /**
@@ -359,7 +968,51 @@ namespace xu
       return sz;
     }
 
+    /**
+      @brief  Returns the number of buffers sharing the underlying allocation, including
+              slices, or 0 if moved from
+      @note   As with std::shared_ptr::use_count(), only a hint when other threads copy
+              or destroy buffers sharing the allocation
+      */
+    long use_count() const
+    {
+      return ptr.use_count();
+    }
+
+    /**
+      @brief  Returns the alignment achieved by data(), i.e. the largest power of two
+              dividing its address
+      @note   Returns 0 if the buffer has no storage
+      */
+    size_t alignment() const
+    {
+      uintptr_t addr = (uintptr_t)ptr.get();
+      return (size_t)(addr & (~addr + 1));
+    }
+
+    /**
+      @brief  Returns the deleter of the underlying allocation, if it is of type Deleter_T
+              Lets backends recognize buffers they created, including slices of them
+      @return Pointer to the deleter, or nullptr if the allocation uses a different deleter
+      */
+    template<typename Deleter_T>
+    Deleter_T* getDeleter() const
+    {
+      return std::get_deleter<Deleter_T>(ptr);
+    }
+
   protected:
+    void checkIndex(size_t i, const char* what) const
+    {
+      checkLive();
+      detail::checkIndex(i, sz, what);
+    }
+
+    void checkLive() const
+    {
+      detail::checkLive(ptr.get(), "shared_buf : use of moved-from buffer");
+    }
+
     //  ================
     //  Member Variables
     //  ================
@@ -367,6 +1020,33 @@ namespace xu
     size_t sz;
     std::shared_ptr<uint8_t[]> ptr;
   };
+
+  /**
+    @brief  Creates a shared buffer whose control block and bytes share a single allocation
+    @param  sz
+            Number of bytes in buffer
+    @note   Bytes are left uninitialized, as with shared_buf(size_t)
+    @note   Falls back to shared_buf(size_t) if the standard library lacks array support
+            in std::make_shared
+    @throw  std::bad_alloc
+            If sz is too large to allocate
+    */
+  inline shared_buf make_shared_buf(size_t sz)
+  {
+    /* the combined allocation adds the control block to sz, which must not wrap */
+    if (sz > (size_t)PTRDIFF_MAX)
+    {
+      throw std::bad_alloc();
+    }
+
+#if defined(__cpp_lib_smart_ptr_for_overwrite)
+    return shared_buf(sz, std::make_shared_for_overwrite<uint8_t[]>(sz));
+#elif defined(__cpp_lib_shared_ptr_arrays) and __cpp_lib_shared_ptr_arrays >= 201707L
+    return shared_buf(sz, std::make_shared<uint8_t[]>(sz));
+#else
+    return shared_buf(sz);
+#endif
+  }
 }
 
 inline std::ostream& operator<<(std::ostream& stream, const xu::shared_buf& buf)
@@ -0,0 +1,205 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2020 Kevin Xu
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#pragma once
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <system_error>
+
+#include <sys/mman.h>
+
+#include "shared_buf.hpp"
+#include "shared_buf_mmap.hpp"
+
+namespace xu
+{
+  enum class huge_pages
+  {
+    /* regular pages */
+    none,
+    /* anonymous mapping with madvise(MADV_HUGEPAGE) */
+    transparent,
+    /* MAP_HUGETLB from the reserved pool, falling back to transparent if none are available */
+    hugetlb
+  };
+
+  struct alloc_options
+  {
+    /* requested alignment of data(), a power of two; 0 means the default heap alignment */
+    size_t alignment = 0;
+    huge_pages huge = huge_pages::none;
+    /* size of a huge page on this system */
+    size_t huge_page_size = size_t(2) << 20;
+  };
+
+  namespace detail
+  {
+    /**
+      @brief  Maps anonymous memory with data aligned to alignment (a multiple of the page size)
+              Over-maps by alignment and unmaps the unaligned head and tail
+      */
+    inline shared_buf mapAligned(size_t sz, size_t alignment, bool thp)
+    {
+      /* the over-mapped length is below sz + alignment */
+      if (sz > SIZE_MAX - alignment)
+      {
+        throw std::bad_alloc();
+      }
+
+      size_t page = pageSize();
+      size_t len = (sz + page - 1) / page * page;
+      if (len == 0)
+      {
+        len = page;
+      }
+
+      size_t over = len + alignment - page;
+      void* raw = ::mmap(nullptr, over, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (raw == MAP_FAILED)
+      {
+        throw std::system_error(errno, std::generic_category(), "xu::make_shared_buf : mmap");
+      }
+
+      uintptr_t start = (uintptr_t)raw;
+      uintptr_t aligned = (start + alignment - 1) & ~(uintptr_t)(alignment - 1);
+      if (aligned > start)
+      {
+        ::munmap(raw, aligned - start);
+      }
+      if (start + over > aligned + len)
+      {
+        ::munmap((void*)(aligned + len), start + over - (aligned + len));
+      }
+
+#ifdef MADV_HUGEPAGE
+      if (thp)
+      {
+        /* a hint only, so failure is not an error */
+        ::madvise((void*)aligned, len, MADV_HUGEPAGE);
+      }
+#else
+      (void)thp;
+#endif
+
+      return shared_buf(sz, std::shared_ptr<uint8_t[]>((uint8_t*)aligned,
+        munmap_deleter{(void*)aligned, len}));
+    }
+
+    /**
+      @brief  Maps anonymous memory from the huge page pool
+      @return Nothing if no huge pages are available
+      */
+    inline std::optional<shared_buf> mapHugetlb(size_t sz, size_t huge_page_size)
+    {
+#ifdef MAP_HUGETLB
+      if (sz > SIZE_MAX - (huge_page_size - 1))
+      {
+        return std::nullopt;
+      }
+
+      size_t len = (sz + huge_page_size - 1) / huge_page_size * huge_page_size;
+      if (len == 0)
+      {
+        len = huge_page_size;
+      }
+
+      void* raw = ::mmap(nullptr, len, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+      if (raw != MAP_FAILED)
+      {
+        return shared_buf(sz, std::shared_ptr<uint8_t[]>((uint8_t*)raw, munmap_deleter{raw, len}));
+      }
+#else
+      (void)sz;
+      (void)huge_page_size;
+#endif
+      return std::nullopt;
+    }
+  }
+
+  /**
+    @brief  Creates a shared buffer with a requested alignment and page size
+    @param  sz
+            Number of bytes in buffer
+    @param  opts
+            Alignment and huge page policy; check alignment() on the result for the
+            alignment actually achieved, which may be larger than requested
+    @note   Alignments below the page size are served from a single heap allocation
+            (over-allocating by the alignment); anything else is an anonymous mapping
+    @note   Bytes are left uninitialized, as with shared_buf(size_t)
+    @throw  std::invalid_argument
+            If alignment is not a power of two
+    @throw  std::bad_alloc
+            If sz plus the alignment overflows
+    @throw  std::system_error
+            If memory cannot be mapped
+    */
+  inline shared_buf make_shared_buf(size_t sz, const alloc_options& opts)
+  {
+    size_t alignment = opts.alignment;
+    if ((alignment & (alignment - 1)) != 0)
+    {
+      throw std::invalid_argument("xu::make_shared_buf : alignment must be a power of two");
+    }
+
+    if (opts.huge == huge_pages::hugetlb)
+    {
+      std::optional<shared_buf> buf = detail::mapHugetlb(sz, opts.huge_page_size);
+      if (buf and buf->alignment() >= alignment)
+      {
+        return std::move(*buf);
+      }
+    }
+
+    if (opts.huge != huge_pages::none)
+    {
+      /* transparent huge pages are only used for huge-page-aligned ranges */
+      size_t huge_alignment = alignment > opts.huge_page_size ? alignment : opts.huge_page_size;
+      return detail::mapAligned(sz, huge_alignment, true);
+    }
+
+    if (alignment >= detail::pageSize())
+    {
+      return detail::mapAligned(sz, alignment, false);
+    }
+
+    if (alignment <= __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+    {
+      return make_shared_buf(sz);
+    }
+
+    if (sz > SIZE_MAX - (alignment - 1))
+    {
+      throw std::bad_alloc();
+    }
+    shared_buf over = make_shared_buf(sz + alignment - 1);
+    size_t lead = (alignment - (uintptr_t)over.data() % alignment) % alignment;
+    return over.slice(lead, sz);
+  }
+}
@@ -0,0 +1,360 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2020 Kevin Xu
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+#if __cplusplus >= 202002L
+#include <span>
+#endif
+
+#include <sys/mman.h>
+
+#include "shared_buf.hpp"
+#include "shared_buf_mmap.hpp"
+#include "shared_buf_view.hpp"
+
+namespace xu
+{
+  /**
+    @brief  Builds a shared buffer of a length not known in advance
+            Capacity grows geometrically; small storage comes from make_shared_buf(), while
+            storage past a threshold is anonymous memory that grows with mremap(), so the
+            kernel moves page tables rather than copying bytes. finish() hands the storage
+            over to a shared_buf of the exact length, without copying
+    */
+  class shared_buf_builder
+  {
+  public:
+    /* capacity from which storage is mapped rather than allocated */
+    static constexpr size_t default_mmap_threshold = size_t(1) << 20;
+
+    //  ================
+    //  Member Functions
+    //  ================
+
+    /**
+      @brief  Constructor
+      @param  capacity
+              Number of bytes to reserve up front
+      @param  mmap_threshold_
+              Capacity from which storage is mapped and grown with mremap()
+      */
+    explicit shared_buf_builder(size_t capacity = 0,
+      size_t mmap_threshold_ = default_mmap_threshold)
+      : heap(0, nullptr),
+        base(nullptr),
+        cap(0),
+        len(0),
+        mapped(false),
+        mmap_threshold(mmap_threshold_)
+    {
+      reserve(capacity);
+    }
+
+    shared_buf_builder(const shared_buf_builder&) = delete;
+    shared_buf_builder& operator=(const shared_buf_builder&) = delete;
+
+    /**
+      @brief  Move constructor
+      */
+    shared_buf_builder(shared_buf_builder&& other) noexcept
+      : heap(std::move(other.heap)),
+        base(std::exchange(other.base, nullptr)),
+        cap(std::exchange(other.cap, 0)),
+        len(std::exchange(other.len, 0)),
+        mapped(std::exchange(other.mapped, false)),
+        mmap_threshold(other.mmap_threshold)
+    {
+
+    }
+
+    /**
+      @brief  Move assignment
+      */
+    shared_buf_builder& operator=(shared_buf_builder&& other) noexcept
+    {
+      if (this != &other)
+      {
+        release();
+        heap = std::move(other.heap);
+        base = std::exchange(other.base, nullptr);
+        cap = std::exchange(other.cap, 0);
+        len = std::exchange(other.len, 0);
+        mapped = std::exchange(other.mapped, false);
+        mmap_threshold = other.mmap_threshold;
+      }
+
+      return *this;
+    }
+
+    /**
+      @brief  Destructor, frees storage that was not handed over by finish()
+      */
+    ~shared_buf_builder()
+    {
+      release();
+    }
+
+    /**
+      @brief  Ensures that capacity() is at least n, so that appending up to n - size()
+              bytes does not reallocate
+      @throw  std::system_error
+              If mapped storage cannot be grown
+      */
+    void reserve(size_t n)
+    {
+      if (n > cap)
+      {
+        reallocate(n);
+      }
+    }
+
+    /**
+      @brief  Appends bytes
+      */
+    void append(const void* bytes, size_t n)
+    {
+      if (n == 0)
+      {
+        return;
+      }
+
+      uintptr_t at = (uintptr_t)bytes;
+      if (at >= (uintptr_t)base and at < (uintptr_t)base + cap)
+      {
+        /* the bytes are our own, and growing may move or free them */
+        size_t offset = at - (uintptr_t)base;
+        uint8_t* dst = extend(n);
+        std::memmove(dst, base + offset, n);
+        return;
+      }
+
+      std::memcpy(extend(n), bytes, n);
+    }
+
+    /**
+      @brief  Appends the bytes of a view, buffer, slice or unique buffer
+      */
+    void append(shared_buf_view bytes)
+    {
+      append(bytes.data(), bytes.size());
+    }
+
+#if __cplusplus >= 202002L
+    /**
+      @brief  Appends the bytes of a span of any byte-sized type
+      @note   A template, so that buffers convert to shared_buf_view rather than to a span
+      */
+    template<typename Byte_T, size_t Extent>
+    void append(std::span<Byte_T, Extent> bytes)
+    {
+      static_assert(sizeof(Byte_T) == 1, "shared_buf_builder::append() : span of bytes expected");
+      append(bytes.data(), bytes.size());
+    }
+#endif
+
+    /**
+      @brief  Appends a byte
+      */
+    void push_back(uint8_t byte)
+    {
+      *extend(1) = byte;
+    }
+
+    /**
+      @brief  Appends n uninitialized bytes, e.g. for read() to fill
+      @return Pointer to the first byte appended, valid until the next append or finish()
+      */
+    uint8_t* extend(size_t n)
+    {
+      if (n > cap - len)
+      {
+        if (n > SIZE_MAX - len)
+        {
+          throw std::length_error("shared_buf_builder::extend() : size overflow");
+        }
+        reallocate(std::max(len + n, cap * 2));
+      }
+
+      uint8_t* at = base + len;
+      len += n;
+      return at;
+    }
+
+    /**
+      @brief  Byte access
+      @param  i
+              Index
+      @throw  std::out_of_range
+              If index is not within size, unless XU_SHARED_BUF_CHECK selects a
+              policy without exceptions
+      */
+    uint8_t& operator[](size_t i)
+    {
+      detail::checkIndex(i, len, "shared_buf_builder::operator[] : index out of range");
+      return base[i];
+    }
+
+    /**
+      @brief  Pointer access, valid until the next append or finish()
+      */
+    uint8_t* data()
+    {
+      return base;
+    }
+
+    /**
+      @brief  Discards the bytes appended so far, keeping the capacity
+      */
+    void clear()
+    {
+      len = 0;
+    }
+
+    /**
+      @brief  Hands the bytes over to a shared buffer of exactly size() bytes, without
+              copying them
+              The builder is left empty, with no capacity
+      @note   Mapped storage is trimmed to whole pages; heap storage keeps its capacity
+              until the buffer is freed
+      */
+    shared_buf finish()
+    {
+      /* empty the builder first, so that it never frees storage the buffer may own */
+      shared_buf owner = std::exchange(heap, shared_buf(0, nullptr));
+      uint8_t* bytes = std::exchange(base, nullptr);
+      size_t map_len = std::exchange(cap, 0);
+      size_t sz = std::exchange(len, 0);
+
+      if (std::exchange(mapped, false))
+      {
+        size_t page = detail::pageSize();
+        size_t used = std::max((sz + page - 1) / page * page, page);
+        if (used < map_len)
+        {
+          /* shrinking in place only unmaps the tail */
+          ::munmap(bytes + used, map_len - used);
+          map_len = used;
+        }
+        return shared_buf(sz, std::shared_ptr<uint8_t[]>(bytes, detail::munmap_deleter{bytes, map_len}));
+      }
+      else if (bytes)
+      {
+        return owner.slice(0, sz);
+      }
+
+      return make_shared_buf(0);
+    }
+
+    /**
+      @brief  Returns the number of bytes appended
+      */
+    size_t size() const
+    {
+      return len;
+    }
+
+    /**
+      @brief  Returns the number of bytes that fit before the storage must grow
+      */
+    size_t capacity() const
+    {
+      return cap;
+    }
+
+  protected:
+    /**
+      @brief  Moves the bytes into storage of at least n bytes
+      */
+    void reallocate(size_t n)
+    {
+      if (n < mmap_threshold)
+      {
+        shared_buf grown = make_shared_buf(std::max(n, size_t(64)));
+        if (len > 0)
+        {
+          std::memcpy(grown.data(), base, len);
+        }
+        heap = std::move(grown);
+        base = heap.data();
+        cap = heap.size();
+        return;
+      }
+
+      size_t page = detail::pageSize();
+      size_t map_len = (n + page - 1) / page * page;
+      void* grown;
+      if (mapped)
+      {
+        grown = ::mremap(base, cap, map_len, MREMAP_MAYMOVE);
+      }
+      else
+      {
+        grown = ::mmap(nullptr, map_len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (grown != MAP_FAILED and len > 0)
+        {
+          std::memcpy(grown, base, len);
+        }
+      }
+      if (grown == MAP_FAILED)
+      {
+        throw std::system_error(errno, std::generic_category(), "xu::shared_buf_builder : mmap");
+      }
+
+      heap = shared_buf(0, nullptr);
+      base = (uint8_t*)grown;
+      cap = map_len;
+      mapped = true;
+    }
+
+    void release()
+    {
+      if (mapped)
+      {
+        ::munmap(base, cap);
+      }
+    }
+
+    //  ================
+    //  Member Variables
+    //  ================
+
+    /* owns the storage below mmap_threshold */
+    shared_buf heap;
+    uint8_t* base;
+    size_t cap;
+    size_t len;
+    /* whether base is an anonymous mapping owned by the builder */
+    bool mapped;
+    size_t mmap_threshold;
+  };
+}
@@ -0,0 +1,425 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2020 Kevin Xu
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <iterator>
+#include <ostream>
+#include <stdexcept>
+
+#include "shared_buf.hpp"
+
+namespace xu
+{
+  /**
+    @brief  Implements a chain of shared buffers, viewed as one logical sequence of bytes
+            Segments are shared, never copied, unless coalesce() is requested
+    */
+  class shared_buf_chain
+  {
+  public:
+    //  =========
+    //  Iterators
+    //  =========
+
+    /**
+      @brief  Segmented iterator
+              Walks each segment with a shared_buf::iterator_, moving to the next
+              segment when the current one is exhausted
+              Forward only: stepping back would have to search for the previous segment
+      */
+    template<typename Val_T, typename Seq_T>
+    class iterator_
+    {
+    protected:
+      using seg_iterator = shared_buf::iterator_<Val_T>;
+
+      Seq_T* segs;
+      size_t seg;
+      seg_iterator it;
+
+      static seg_iterator segBegin(Seq_T* segs, size_t seg)
+      {
+        if (seg < segs->size())
+        {
+          /* as in shared_buf, const iterators hold a non-const base pointer */
+          return seg_iterator(const_cast<uint8_t*>((*segs)[seg].data()), (*segs)[seg].size());
+        }
+        else
+        {
+          return seg_iterator(nullptr, 0);
+        }
+      }
+
+    public:
+      using iterator_category = std::forward_iterator_tag;
+      using value_type = uint8_t;
+      using difference_type = std::ptrdiff_t;
+      using pointer = Val_T*;
+      using reference = Val_T&;
+
+      /**
+        @brief  Constructor, creates an iterator into no chain, equal only to another such
+        */
+      iterator_()
+        : segs(nullptr),
+          seg(0),
+          it(nullptr, 0)
+      {}
+
+      iterator_(Seq_T* segs_, size_t seg_)
+        : segs(segs_),
+          seg(seg_),
+          it(segBegin(segs_, seg_))
+      {}
+
+      iterator_& operator++()
+      {
+        if (seg < segs->size())
+        {
+          ++it;
+          if (it - segBegin(segs, seg) == (*segs)[seg].size())
+          {
+            seg++;
+            it = segBegin(segs, seg);
+          }
+        }
+        return *this;
+      }
+
+      iterator_ operator++(int)
+      {
+        iterator_ res = *this;
+        operator++();
+        return res;
+      }
+
+      bool operator==(const iterator_& other) const
+      {
+        return (segs == other.segs
+          and seg == other.seg
+          and it == other.it);
+      }
+
+      bool operator!=(const iterator_& other) const
+      {
+        return not operator==(other);
+      }
+
+      Val_T& operator*() const
+      {
+        return *it;
+      }
+
+      Val_T* operator->() const
+      {
+        return &*it;
+      }
+
+      /**
+        @brief  Returns the iterator within the current segment
+        */
+      const seg_iterator& segmentIterator() const
+      {
+        return it;
+      }
+
+      /**
+        @brief  Returns the index of the current segment
+        */
+      size_t segmentIndex() const
+      {
+        return seg;
+      }
+
+      operator iterator_<const Val_T, const Seq_T>() const
+      {
+        iterator_<const Val_T, const Seq_T> res(segs, seg);
+        res.it = it;
+        return res;
+      }
+
+      template<typename, typename>
+      friend class iterator_;
+    };
+
+    using iterator = iterator_<uint8_t, std::deque<shared_buf>>;
+    using const_iterator = iterator_<const uint8_t, const std::deque<shared_buf>>;
+
+    iterator begin()
+    {
+      return iterator(&segs, 0);
+    }
+
+    iterator end()
+    {
+      return iterator(&segs, segs.size());
+    }
+
+    const_iterator begin() const
+    {
+      return const_iterator(&segs, 0);
+    }
+
+    const_iterator end() const
+    {
+      return const_iterator(&segs, segs.size());
+    }
+
+    //  ================
+    //  Member Functions
+    //  ================
+
+    /**
+      @brief  Constructor, creates an empty chain
+      */
+    shared_buf_chain()
+      : total(0)
+    {
+
+    }
+
+    /**
+      @brief  Constructor, creates a chain with a single segment
+      */
+    shared_buf_chain(shared_buf buf)
+      : total(0)
+    {
+      append(std::move(buf));
+    }
+
+    /**
+      @brief  Appends a segment
+      @note   Empty buffers are ignored
+      */
+    void append(shared_buf buf)
+    {
+      if (buf.size() > 0)
+      {
+        total += buf.size();
+        segs.push_back(std::move(buf));
+      }
+    }
+
+    /**
+      @brief  Appends all segments of another chain
+      */
+    void append(shared_buf_chain other)
+    {
+      for (auto& buf : other.segs)
+      {
+        append(std::move(buf));
+      }
+    }
+
+    /**
+      @brief  Prepends a segment
+      @note   Empty buffers are ignored
+      */
+    void prepend(shared_buf buf)
+    {
+      if (buf.size() > 0)
+      {
+        total += buf.size();
+        segs.push_front(std::move(buf));
+      }
+    }
+
+    /**
+      @brief  Splits the chain at an offset
+              This chain keeps bytes [0, offset), and the remainder is returned
+              A segment straddling offset is sliced, not copied
+      @throw  std::out_of_range
+              If offset is greater than size
+      */
+    shared_buf_chain split(size_t offset)
+    {
+      if (offset > total)
+      {
+        throw std::out_of_range("shared_buf_chain::split() : offset out of range");
+      }
+
+      shared_buf_chain tail;
+
+      size_t pos = 0;
+      size_t seg = 0;
+      while (seg < segs.size() and pos + segs[seg].size() <= offset)
+      {
+        pos += segs[seg].size();
+        seg++;
+      }
+
+      if (seg < segs.size() and pos < offset)
+      {
+        shared_buf& straddling = segs[seg];
+        tail.append(straddling.slice(offset - pos));
+        straddling = straddling.slice(0, offset - pos);
+        seg++;
+      }
+
+      for (size_t i = seg; i < segs.size(); i++)
+      {
+        tail.append(std::move(segs[i]));
+      }
+      segs.erase(segs.begin() + seg, segs.end());
+
+      total = offset;
+
+      return tail;
+    }
+
+    /**
+      @brief  Returns the chain as one contiguous buffer
+              If the chain has several segments they are copied into a new buffer,
+              which then replaces them; a single segment is returned as-is
+      */
+    shared_buf coalesce()
+    {
+      if (segs.size() == 1)
+      {
+        return segs.front();
+      }
+
+      shared_buf res = make_shared_buf(total);
+
+      size_t pos = 0;
+      for (const auto& buf : segs)
+      {
+        std::memcpy(res.data() + pos, buf.data(), buf.size());
+        pos += buf.size();
+      }
+
+      segs.clear();
+      append(res);
+
+      return res;
+    }
+
+    /**
+      @brief  Byte access
+      @note   Linear in the number of segments
+      @throw  std::out_of_range
+              If index is not within size, unless XU_SHARED_BUF_CHECK selects a
+              policy without exceptions
+      */
+    uint8_t& operator[](size_t i)
+    {
+      detail::checkIndex(i, total, "shared_buf_chain::operator[] : index out of range");
+
+      /* segments are never empty, so an index within size stops inside one */
+      auto it = segs.begin();
+      while (i >= it->size())
+      {
+        i -= it->size();
+        ++it;
+      }
+      return (*it)[i];
+    }
+
+    /**
+      @brief  Byte access, const-qualified
+      @note   Linear in the number of segments
+      @throw  std::out_of_range
+              If index is not within size, unless XU_SHARED_BUF_CHECK selects a
+              policy without exceptions
+      */
+    const uint8_t& operator[](size_t i) const
+    {
+      detail::checkIndex(i, total, "shared_buf_chain::operator[] : index out of range");
+
+      /* segments are never empty, so an index within size stops inside one */
+      auto it = segs.begin();
+      while (i >= it->size())
+      {
+        i -= it->size();
+        ++it;
+      }
+      return (*it)[i];
+    }
+
+    /**
+      @brief  Segment access
+      */
+    const std::deque<shared_buf>& segments() const
+    {
+      return segs;
+    }
+
+    /**
+      @brief  Output to string, in the same format as shared_buf
+      @param  fmt
+              Hex layout, [01,02,...] by default
+      */
+    std::ostream& print(std::ostream& stream, const hex_format& fmt = hex_format()) const
+    {
+      hex_format seg_fmt = fmt;
+      seg_fmt.brackets = false;
+
+      if (fmt.brackets)
+      {
+        stream << '[';
+      }
+
+      for (auto it = segs.begin(); it != segs.end(); it++)
+      {
+        if (it != segs.begin() and fmt.separator != '\0')
+        {
+          stream << fmt.separator;
+        }
+        it->print(stream, seg_fmt);
+      }
+
+      if (fmt.brackets)
+      {
+        stream << ']';
+      }
+
+      return stream;
+    }
+
+    /**
+      @brief  Returns total size in bytes
+      */
+    size_t size() const
+    {
+      return total;
+    }
+
+  protected:
+    //  ================
+    //  Member Variables
+    //  ================
+
+    std::deque<shared_buf> segs;
+    size_t total;
+  };
+}
+
+inline std::ostream& operator<<(std::ostream& stream, const xu::shared_buf_chain& chain)
+{
+  return chain.print(stream);
+}
@@ -0,0 +1,212 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2020 Kevin Xu
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#if __has_include(<thread>)
+#include <thread>
+#define XU_SHARED_BUF_HAS_THREADS 1
+#else
+#define XU_SHARED_BUF_HAS_THREADS 0
+#endif
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+/* only for sysconf(); without it the cache size is guessed */
+#if __has_include(<unistd.h>)
+#include <unistd.h>
+#endif
+
+namespace xu
+{
+  struct copy_options
+  {
+    /* copies at least this large bypass the cache with streaming stores; 0 means the LLC size */
+    size_t streaming_threshold = 0;
+    /* maximum number of threads to copy with, ignored without std::thread */
+    unsigned threads = 1;
+    /* copies are only split across threads when at least this large */
+    size_t parallel_threshold = size_t(32) << 20;
+  };
+
+  namespace detail
+  {
+    /**
+      @brief  Returns the size of the last-level cache, or a conservative guess
+      */
+    inline size_t llcSize()
+    {
+      static const size_t llc = []()
+      {
+        long sz = 0;
+#ifdef _SC_LEVEL3_CACHE_SIZE
+        sz = ::sysconf(_SC_LEVEL3_CACHE_SIZE);
+#endif
+#ifdef _SC_LEVEL2_CACHE_SIZE
+        if (sz <= 0)
+        {
+          sz = ::sysconf(_SC_LEVEL2_CACHE_SIZE);
+        }
+#endif
+        return sz > 0 ? (size_t)sz : (size_t(8) << 20);
+      }();
+      return llc;
+    }
+
+    /**
+      @brief  Copies with non-temporal stores, so the destination does not evict the cache
+      @note   Falls back to memcpy where streaming stores are not available
+      */
+    inline void streamCopy(uint8_t* dst, const uint8_t* src, size_t n)
+    {
+#if defined(__AVX__)
+      constexpr size_t vec = 32;
+#elif defined(__SSE2__)
+      constexpr size_t vec = 16;
+#endif
+
+#if defined(__SSE2__)
+      /* align the destination, as required by streaming stores */
+      size_t head = (vec - (uintptr_t)dst % vec) % vec;
+      if (head > n)
+      {
+        head = n;
+      }
+      std::memcpy(dst, src, head);
+      dst += head;
+      src += head;
+      n -= head;
+
+      size_t body = n - n % (4 * vec);
+      for (size_t i = 0; i < body; i += 4 * vec)
+      {
+#if defined(__AVX__)
+        __m256i a = _mm256_loadu_si256((const __m256i*)(src + i));
+        __m256i b = _mm256_loadu_si256((const __m256i*)(src + i + 32));
+        __m256i c = _mm256_loadu_si256((const __m256i*)(src + i + 64));
+        __m256i d = _mm256_loadu_si256((const __m256i*)(src + i + 96));
+        _mm256_stream_si256((__m256i*)(dst + i), a);
+        _mm256_stream_si256((__m256i*)(dst + i + 32), b);
+        _mm256_stream_si256((__m256i*)(dst + i + 64), c);
+        _mm256_stream_si256((__m256i*)(dst + i + 96), d);
+#else
+        __m128i a = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i b = _mm_loadu_si128((const __m128i*)(src + i + 16));
+        __m128i c = _mm_loadu_si128((const __m128i*)(src + i + 32));
+        __m128i d = _mm_loadu_si128((const __m128i*)(src + i + 48));
+        _mm_stream_si128((__m128i*)(dst + i), a);
+        _mm_stream_si128((__m128i*)(dst + i + 16), b);
+        _mm_stream_si128((__m128i*)(dst + i + 32), c);
+        _mm_stream_si128((__m128i*)(dst + i + 48), d);
+#endif
+      }
+
+      /* streaming stores are weakly ordered */
+      _mm_sfence();
+
+      std::memcpy(dst + body, src + body, n - body);
+#else
+      std::memcpy(dst, src, n);
+#endif
+    }
+
+    inline void copyChunk(uint8_t* dst, const uint8_t* src, size_t n, size_t streaming_threshold)
+    {
+      if (n >= streaming_threshold)
+      {
+        streamCopy(dst, src, n);
+      }
+      else
+      {
+        std::memcpy(dst, src, n);
+      }
+    }
+  }
+
+  /**
+    @brief  Bandwidth-oriented copy of n bytes between non-overlapping ranges
+            Small and medium copies use memcpy, whose SIMD implementation is hard to beat;
+            copies larger than the last-level cache use streaming stores, and very large
+            copies may be split across threads
+    */
+  inline void copy_bytes(uint8_t* dst, const uint8_t* src, size_t n, const copy_options& opts = copy_options())
+  {
+    if (n == 0)
+    {
+      return;
+    }
+
+    size_t threshold = opts.streaming_threshold != 0 ? opts.streaming_threshold : detail::llcSize();
+
+    if (not XU_SHARED_BUF_HAS_THREADS or opts.threads <= 1 or n < opts.parallel_threshold)
+    {
+      detail::copyChunk(dst, src, n, threshold);
+      return;
+    }
+
+#if XU_SHARED_BUF_HAS_THREADS
+    /*
+     *  Whole-page chunks, split at page boundaries of the destination's addresses rather than
+     *  at offsets from dst, so threads never share a destination cache line; the first chunk
+     *  also takes the bytes before dst's first boundary
+     */
+    const size_t page = 4096;
+    size_t chunk = ((n + opts.threads - 1) / opts.threads + page - 1) / page * page;
+    size_t lead = (page - (uintptr_t)dst % page) % page;
+    size_t first = lead + chunk < n ? lead + chunk : n;
+
+    /* each thread's share is compared against the threshold as a whole copy would be */
+    std::vector<std::thread> threads;
+    threads.reserve(opts.threads);
+
+    /* joins the threads started so far even if starting another one throws */
+    struct joiner
+    {
+      std::vector<std::thread>& threads;
+
+      ~joiner()
+      {
+        for (auto& th : threads)
+        {
+          th.join();
+        }
+      }
+    } join_all{threads};
+
+    for (size_t pos = first; pos < n; pos += chunk)
+    {
+      size_t len = n - pos < chunk ? n - pos : chunk;
+      threads.emplace_back(detail::copyChunk, dst + pos, src + pos, len, threshold / opts.threads);
+    }
+
+    detail::copyChunk(dst, src, first, threshold / opts.threads);
+#endif
+  }
+}
@@ -0,0 +1,519 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2020 Kevin Xu
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#pragma once
+
+#if __cplusplus < 202002L
+#error "shared_buf_cursor.hpp requires C++20"
+#endif
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+#include "shared_buf.hpp"
+#include "shared_buf_view.hpp"
+
+namespace xu
+{
+  namespace detail
+  {
+    /*
+     *  std::byteswap where available, else the compiler builtin, else shifts, which
+     *  compilers recognize as a bswap
+     */
+    inline uint16_t byteswap(uint16_t v)
+    {
+#if defined(__cpp_lib_byteswap)
+      return std::byteswap(v);
+#elif defined(__GNUC__)
+      return __builtin_bswap16(v);
+#else
+      return (uint16_t)((v << 8) | (v >> 8));
+#endif
+    }
+
+    inline uint32_t byteswap(uint32_t v)
+    {
+#if defined(__cpp_lib_byteswap)
+      return std::byteswap(v);
+#elif defined(__GNUC__)
+      return __builtin_bswap32(v);
+#else
+      return (uint32_t)byteswap((uint16_t)v) << 16 | byteswap((uint16_t)(v >> 16));
+#endif
+    }
+
+    inline uint64_t byteswap(uint64_t v)
+    {
+#if defined(__cpp_lib_byteswap)
+      return std::byteswap(v);
+#elif defined(__GNUC__)
+      return __builtin_bswap64(v);
+#else
+      return (uint64_t)byteswap((uint32_t)v) << 32 | byteswap((uint32_t)(v >> 32));
+#endif
+    }
+
+    /**
+      @brief  Loads an unsigned integer stored in byte order Order at any alignment
+              Compiles to a single load, plus a bswap if Order is not native
+      */
+    template<typename T, std::endian Order>
+    inline T loadEndian(const uint8_t* p)
+    {
+      T v;
+      std::memcpy(&v, p, sizeof(T));
+      if constexpr (Order != std::endian::native and sizeof(T) > 1)
+      {
+        v = byteswap(v);
+      }
+      return v;
+    }
+
+    /**
+      @brief  Stores an unsigned integer in byte order Order at any alignment
+      */
+    template<typename T, std::endian Order>
+    inline void storeEndian(uint8_t* p, T v)
+    {
+      if constexpr (Order != std::endian::native and sizeof(T) > 1)
+      {
+        v = byteswap(v);
+      }
+      std::memcpy(p, &v, sizeof(T));
+    }
+
+    /* longest encoding of a 64-bit varint */
+    constexpr size_t max_varint_length = 10;
+  }
+
+  /**
+    @brief  Reads typed values from bytes, advancing a position
+            Each operation checks bounds once, then loads directly, so a fixed-size field
+            costs a compare and a load (plus bswap); record() checks a whole fixed layout
+            once and hands back an unchecked reader for it
+    @tparam Order
+            Byte order of multi-byte values; individual reads can override it
+    @tparam Checked
+            If false, bounds are only assert()ed, as in readers returned by record();
+            varints and strings, whose length depends on the data, are checked regardless
+    @note   The bytes must outlive the reader, and views it returns
+    */
+  template<std::endian Order = std::endian::big, bool Checked = true>
+  class buf_reader
+  {
+  public:
+    //  ================
+    //  Member Functions
+    //  ================
+
+    /**
+      @brief  Constructor, reads from the start of a buffer, slice or view
+      */
+    explicit buf_reader(shared_buf_view bytes_)
+      : ptr(bytes_.data()),
+        sz(bytes_.size()),
+        pos(0)
+    {
+
+    }
+
+    /**
+      @throw  std::out_of_range
+              If fewer bytes remain than the value needs, in every read function
+      */
+    uint8_t readU8()
+    {
+      return *take(1, "buf_reader::readU8() : not enough bytes");
+    }
+
+    template<std::endian O = Order>
+    uint16_t readU16()
+    {
+      return detail::loadEndian<uint16_t, O>(take(2, "buf_reader::readU16() : not enough bytes"));
+    }
+
+    template<std::endian O = Order>
+    uint32_t readU32()
+    {
+      return detail::loadEndian<uint32_t, O>(take(4, "buf_reader::readU32() : not enough bytes"));
+    }
+
+    template<std::endian O = Order>
+    uint64_t readU64()
+    {
+      return detail::loadEndian<uint64_t, O>(take(8, "buf_reader::readU64() : not enough bytes"));
+    }
+
+    template<std::endian O = Order>
+    float readF32()
+    {
+      return std::bit_cast<float>(detail::loadEndian<uint32_t, O>(
+        take(4, "buf_reader::readF32() : not enough bytes")));
+    }
+
+    template<std::endian O = Order>
+    double readF64()
+    {
+      return std::bit_cast<double>(detail::loadEndian<uint64_t, O>(
+        take(8, "buf_reader::readF64() : not enough bytes")));
+    }
+
+    /**
+      @brief  Reads an unsigned LEB128 varint, as in Protocol Buffers
+      @throw  std::out_of_range
+              If the input ends inside the varint
+      @throw  decode_error
+              If the varint is longer than 10 bytes or overflows 64 bits
+      */
+    uint64_t readVarint()
+    {
+      size_t start = pos;
+      size_t limit = std::min(sz - pos, detail::max_varint_length);
+      uint64_t v = 0;
+
+      for (size_t i = 0; i < limit; i++)
+      {
+        uint8_t b = ptr[pos + i];
+        v |= (uint64_t)(b & 0x7f) << (7 * i);
+        if (b < 0x80)
+        {
+          if (i == detail::max_varint_length - 1 and b > 1)
+          {
+            throw decode_error("buf_reader::readVarint() : varint overflows 64 bits", start);
+          }
+          pos += i + 1;
+          return v;
+        }
+      }
+
+      if (limit == detail::max_varint_length)
+      {
+        throw decode_error("buf_reader::readVarint() : varint longer than 10 bytes", start);
+      }
+      throw std::out_of_range("buf_reader::readVarint() : not enough bytes");
+    }
+
+    /**
+      @brief  Returns a view of the next n bytes, without copying them
+      */
+    shared_buf_view readBytes(size_t n)
+    {
+      return shared_buf_view(take(n, "buf_reader::readBytes() : not enough bytes"), n);
+    }
+
+    /**
+      @brief  Reads a string prefixed with its length as a varint
+      */
+    std::string_view readString()
+    {
+      uint64_t n = readVarint();
+      if (n > sz - pos)
+      {
+        throw std::out_of_range("buf_reader::readString() : not enough bytes");
+      }
+      return readBytes((size_t)n).bytes();
+    }
+
+    /**
+      @brief  Checks once that a record of n bytes remains, and returns an unchecked reader
+              for it; this reader moves past the record
+      @throw  std::out_of_range
+              If fewer than n bytes remain
+      */
+    buf_reader<Order, false> record(size_t n)
+    {
+      return buf_reader<Order, false>(readBytes(n));
+    }
+
+    /**
+      @brief  Moves past n bytes
+      */
+    void skip(size_t n)
+    {
+      take(n, "buf_reader::skip() : not enough bytes");
+    }
+
+    /**
+      @brief  Returns the number of bytes read so far
+      */
+    size_t position() const
+    {
+      return pos;
+    }
+
+    /**
+      @brief  Returns the number of bytes left
+      */
+    size_t remaining() const
+    {
+      return sz - pos;
+    }
+
+  protected:
+    /**
+      @brief  Claims the next n bytes
+      */
+    const uint8_t* take(size_t n, const char* what)
+    {
+      if constexpr (Checked)
+      {
+        if (n > sz - pos)
+        {
+          throw std::out_of_range(what);
+        }
+      }
+      else
+      {
+        assert(n <= sz - pos and what);
+      }
+
+      const uint8_t* at = ptr + pos;
+      pos += n;
+      return at;
+    }
+
+    //  ================
+    //  Member Variables
+    //  ================
+
+    const uint8_t* ptr;
+    size_t sz;
+    size_t pos;
+  };
+
+  /**
+    @brief  Writes typed values into bytes, advancing a position
+            The counterpart of buf_reader, with the same bounds checking
+    @tparam Order
+            Byte order of multi-byte values; individual writes can override it
+    @tparam Checked
+            If false, bounds are only assert()ed, as in writers returned by record();
+            varints and strings, whose length depends on the data, are checked regardless
+    @note   A writer made from a buffer keeps it alive; bytes given by pointer must
+            outlive the writer
+    */
+  template<std::endian Order = std::endian::big, bool Checked = true>
+  class buf_writer
+  {
+  public:
+    //  ================
+    //  Member Functions
+    //  ================
+
+    /**
+      @brief  Constructor, writes from the start of a buffer or slice
+      @note   Takes the handle by value, so that a temporary slice can be passed
+      */
+    explicit buf_writer(shared_buf buf)
+      : ptr(buf.data()),
+        sz(buf.size()),
+        pos(0),
+        owner(std::move(buf))
+    {
+
+    }
+
+    /**
+      @brief  Constructor
+      @param  ptr_
+              First byte
+      @param  sz_
+              Number of bytes that may be written
+      */
+    buf_writer(uint8_t* ptr_, size_t sz_)
+      : ptr(ptr_),
+        sz(sz_),
+        pos(0),
+        owner(0, nullptr)
+    {
+
+    }
+
+    /**
+      @throw  std::out_of_range
+              If fewer bytes remain than the value needs, in every write function
+      */
+    void writeU8(uint8_t v)
+    {
+      *take(1, "buf_writer::writeU8() : not enough space") = v;
+    }
+
+    template<std::endian O = Order>
+    void writeU16(uint16_t v)
+    {
+      detail::storeEndian<uint16_t, O>(take(2, "buf_writer::writeU16() : not enough space"), v);
+    }
+
+    template<std::endian O = Order>
+    void writeU32(uint32_t v)
+    {
+      detail::storeEndian<uint32_t, O>(take(4, "buf_writer::writeU32() : not enough space"), v);
+    }
+
+    template<std::endian O = Order>
+    void writeU64(uint64_t v)
+    {
+      detail::storeEndian<uint64_t, O>(take(8, "buf_writer::writeU64() : not enough space"), v);
+    }
+
+    template<std::endian O = Order>
+    void writeF32(float v)
+    {
+      detail::storeEndian<uint32_t, O>(take(4, "buf_writer::writeF32() : not enough space"),
+        std::bit_cast<uint32_t>(v));
+    }
+
+    template<std::endian O = Order>
+    void writeF64(double v)
+    {
+      detail::storeEndian<uint64_t, O>(take(8, "buf_writer::writeF64() : not enough space"),
+        std::bit_cast<uint64_t>(v));
+    }
+
+    /**
+      @brief  Writes an unsigned LEB128 varint
+      */
+    void writeVarint(uint64_t v)
+    {
+      uint8_t encoded[detail::max_varint_length];
+      size_t n = 0;
+      while (v >= 0x80)
+      {
+        encoded[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+      }
+      encoded[n++] = (uint8_t)v;
+
+      if (n > sz - pos)
+      {
+        throw std::out_of_range("buf_writer::writeVarint() : not enough space");
+      }
+      std::memcpy(take(n, "buf_writer::writeVarint() : not enough space"), encoded, n);
+    }
+
+    /**
+      @brief  Copies bytes
+      */
+    void writeBytes(shared_buf_view bytes)
+    {
+      uint8_t* at = take(bytes.size(), "buf_writer::writeBytes() : not enough space");
+      if (bytes.size() > 0)
+      {
+        std::memcpy(at, bytes.data(), bytes.size());
+      }
+    }
+
+    /**
+      @brief  Writes a string prefixed with its length as a varint
+      @note   Writes nothing if the whole string does not fit
+      */
+    void writeString(std::string_view str)
+    {
+      size_t start = pos;
+      writeVarint(str.size());
+      if (str.size() > sz - pos)
+      {
+        pos = start;
+        throw std::out_of_range("buf_writer::writeString() : not enough space");
+      }
+      writeBytes(shared_buf_view((const uint8_t*)str.data(), str.size()));
+    }
+
+    /**
+      @brief  Checks once that n bytes of space remain, and returns an unchecked writer for
+              them; this writer moves past them
+      @throw  std::out_of_range
+              If fewer than n bytes remain
+      */
+    buf_writer<Order, false> record(size_t n)
+    {
+      return buf_writer<Order, false>(take(n, "buf_writer::record() : not enough space"), n);
+    }
+
+    /**
+      @brief  Moves past n bytes, leaving them as they are
+      */
+    void skip(size_t n)
+    {
+      take(n, "buf_writer::skip() : not enough space");
+    }
+
+    /**
+      @brief  Returns the number of bytes written so far
+      */
+    size_t position() const
+    {
+      return pos;
+    }
+
+    /**
+      @brief  Returns the space left
+      */
+    size_t remaining() const
+    {
+      return sz - pos;
+    }
+
+  protected:
+    /**
+      @brief  Claims the next n bytes
+      */
+    uint8_t* take(size_t n, const char* what)
+    {
+      if constexpr (Checked)
+      {
+        if (n > sz - pos)
+        {
+          throw std::out_of_range(what);
+        }
+      }
+      else
+      {
+        assert(n <= sz - pos and what);
+      }
+
+      uint8_t* at = ptr + pos;
+      pos += n;
+      return at;
+    }
+
+    //  ================
+    //  Member Variables
+    //  ================
+
+    uint8_t* ptr;
+    size_t sz;
+    size_t pos;
+    /* the buffer written into, if any */
+    shared_buf owner;
+  };
+}
@@ -0,0 +1,347 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2020 Kevin Xu
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace xu
+{
+  /**
+    @brief  Layout of hex output
+            The default is the shared_buf print() format, e.g. [01,02,ff]
+    */
+  struct hex_format
+  {
+    bool uppercase = false;
+    /* character written between bytes, or '\0' for none */
+    char separator = ',';
+    /* enclose the output in [] */
+    bool brackets = true;
+  };
+
+  /**
+    @brief  Returns the format with no brackets or separators, e.g. 0102ff
+    */
+  inline hex_format compact_hex(bool uppercase = false)
+  {
+    hex_format fmt;
+    fmt.uppercase = uppercase;
+    fmt.separator = '\0';
+    fmt.brackets = false;
+    return fmt;
+  }
+
+  /**
+    @brief  Thrown when encoded input is malformed
+    */
+  class decode_error : public std::invalid_argument
+  {
+  public:
+    decode_error(const std::string& what, size_t position_)
+      : std::invalid_argument(what + " at offset " + std::to_string(position_)),
+        pos(position_)
+    {}
+
+    /**
+      @brief  Returns the offset in the input of the first offending character
+      */
+    size_t position() const
+    {
+      return pos;
+    }
+
+  protected:
+    size_t pos;
+  };
+
+  namespace detail
+  {
+    struct hex_table
+    {
+      char pairs[256][2];
+
+      constexpr hex_table(const char* digits)
+        : pairs()
+      {
+        for (int i = 0; i < 256; i++)
+        {
+          pairs[i][0] = digits[i >> 4];
+          pairs[i][1] = digits[i & 0xf];
+        }
+      }
+    };
+
+    inline constexpr hex_table hex_lower("0123456789abcdef");
+    inline constexpr hex_table hex_upper("0123456789ABCDEF");
+
+    /**
+      @brief  Writes 2 * n hex digits with no separators
+      */
+    inline void formatHexDigits(char* out, const uint8_t* data, size_t n, bool uppercase)
+    {
+      const hex_table& table = uppercase ? hex_upper : hex_lower;
+      size_t i = 0;
+
+#if defined(__SSSE3__)
+      const __m128i lut = uppercase
+        ? _mm_setr_epi8('0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F')
+        : _mm_setr_epi8('0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f');
+      const __m128i low_nibble = _mm_set1_epi8(0x0f);
+
+      for (; i + 16 <= n; i += 16)
+      {
+        __m128i v = _mm_loadu_si128((const __m128i*)(data + i));
+        __m128i hi = _mm_shuffle_epi8(lut, _mm_and_si128(_mm_srli_epi16(v, 4), low_nibble));
+        __m128i lo = _mm_shuffle_epi8(lut, _mm_and_si128(v, low_nibble));
+        _mm_storeu_si128((__m128i*)(out + 2 * i), _mm_unpacklo_epi8(hi, lo));
+        _mm_storeu_si128((__m128i*)(out + 2 * i + 16), _mm_unpackhi_epi8(hi, lo));
+      }
+#endif
+
+      for (; i < n; i++)
+      {
+        std::memcpy(out + 2 * i, table.pairs[data[i]], 2);
+      }
+    }
+  }
+
+  namespace detail
+  {
+    /**
+      @brief  Returns the value of a hex digit, or -1
+      */
+    inline int hexValue(char c)
+    {
+      if (c >= '0' and c <= '9')
+      {
+        return c - '0';
+      }
+      c |= 0x20;
+      if (c >= 'a' and c <= 'f')
+      {
+        return c - 'a' + 10;
+      }
+      return -1;
+    }
+
+    inline void decodeHexScalar(uint8_t* out, const char* in, size_t n, size_t base)
+    {
+      for (size_t i = 0; i < n; i += 2)
+      {
+        int hi = hexValue(in[i]);
+        if (hi < 0)
+        {
+          throw decode_error("xu::decode_hex : invalid hex digit", base + i);
+        }
+        int lo = hexValue(in[i + 1]);
+        if (lo < 0)
+        {
+          throw decode_error("xu::decode_hex : invalid hex digit", base + i + 1);
+        }
+        out[i / 2] = (uint8_t)(hi << 4 | lo);
+      }
+    }
+  }
+
+  /**
+    @brief  Decodes compact hex (e.g. 0102ff, in either case) into n / 2 bytes
+    @param  out
+            Destination, with room for at least n / 2 bytes
+    @throw  decode_error
+            If n is odd or any character is not a hex digit
+    */
+  inline void decode_hex(uint8_t* out, const char* in, size_t n)
+  {
+    if (n % 2 != 0)
+    {
+      throw decode_error("xu::decode_hex : odd number of hex digits", n);
+    }
+
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    const __m128i ascii_zero = _mm_set1_epi8('0');
+    const __m128i ascii_a = _mm_set1_epi8('a');
+    const __m128i case_bit = _mm_set1_epi8(0x20);
+    const __m128i minus_one = _mm_set1_epi8(-1);
+    const __m128i ten = _mm_set1_epi8(10);
+    const __m128i six = _mm_set1_epi8(6);
+    const __m128i low_byte = _mm_set1_epi16(0x00ff);
+
+    for (; i + 16 <= n; i += 16)
+    {
+      __m128i v = _mm_loadu_si128((const __m128i*)(in + i));
+
+      /* each byte is valid in exactly one of the two ranges, compared as signed after the shift */
+      __m128i d = _mm_sub_epi8(v, ascii_zero);
+      __m128i is_digit = _mm_and_si128(_mm_cmpgt_epi8(d, minus_one), _mm_cmplt_epi8(d, ten));
+      __m128i l = _mm_sub_epi8(_mm_or_si128(v, case_bit), ascii_a);
+      __m128i is_alpha = _mm_and_si128(_mm_cmpgt_epi8(l, minus_one), _mm_cmplt_epi8(l, six));
+
+      if (_mm_movemask_epi8(_mm_or_si128(is_digit, is_alpha)) != 0xffff)
+      {
+        /* let the scalar path find the offending character */
+        break;
+      }
+
+      __m128i nibbles = _mm_or_si128(_mm_and_si128(is_digit, d),
+        _mm_and_si128(is_alpha, _mm_add_epi8(l, ten)));
+
+      /* each 16-bit lane holds (high nibble, low nibble) as (low byte, high byte) */
+      __m128i bytes = _mm_or_si128(
+        _mm_slli_epi16(_mm_and_si128(nibbles, low_byte), 4),
+        _mm_srli_epi16(nibbles, 8));
+      _mm_storel_epi64((__m128i*)(out + i / 2), _mm_packus_epi16(bytes, bytes));
+    }
+#endif
+
+    detail::decodeHexScalar(out + i / 2, in + i, n - i, i);
+  }
+
+  /**
+    @brief  Returns the number of characters format_hex() writes for n bytes
+    */
+  inline size_t hex_length(size_t n, const hex_format& fmt = hex_format())
+  {
+    size_t len = 2 * n;
+    if (fmt.separator != '\0' and n > 0)
+    {
+      len += n - 1;
+    }
+    if (fmt.brackets)
+    {
+      len += 2;
+    }
+    return len;
+  }
+
+  /**
+    @brief  Formats bytes as hex in one pass
+    @param  out
+            Destination, with room for at least hex_length(n, fmt) characters;
+            no terminating null is written
+    @return Number of characters written
+    */
+  inline size_t format_hex(char* out, const uint8_t* data, size_t n, const hex_format& fmt = hex_format())
+  {
+    char* pos = out;
+
+    if (fmt.brackets)
+    {
+      *pos++ = '[';
+    }
+
+    if (fmt.separator == '\0')
+    {
+      detail::formatHexDigits(pos, data, n, fmt.uppercase);
+      pos += 2 * n;
+    }
+    else
+    {
+      const detail::hex_table& table = fmt.uppercase ? detail::hex_upper : detail::hex_lower;
+      for (size_t i = 0; i < n; i++)
+      {
+        if (i != 0)
+        {
+          *pos++ = fmt.separator;
+        }
+        std::memcpy(pos, table.pairs[data[i]], 2);
+        pos += 2;
+      }
+    }
+
+    if (fmt.brackets)
+    {
+      *pos++ = ']';
+    }
+
+    return pos - out;
+  }
+
+  /**
+    @brief  Formats bytes as a hex string
+    */
+  inline std::string to_hex(const uint8_t* data, size_t n, const hex_format& fmt = hex_format())
+  {
+    std::string res(hex_length(n, fmt), '\0');
+    format_hex(res.data(), data, n, fmt);
+    return res;
+  }
+
+  /**
+    @brief  Writes bytes to a stream as hex
+            Formats into a stack buffer and issues one stream.write per 1 KiB of input
+    */
+  inline std::ostream& print_hex(std::ostream& stream, const uint8_t* data, size_t n,
+    const hex_format& fmt = hex_format())
+  {
+    constexpr size_t chunk = 1024;
+    char out[3 * chunk + 2];
+
+    if (n <= chunk)
+    {
+      stream.write(out, format_hex(out, data, n, fmt));
+      return stream;
+    }
+
+    hex_format body = fmt;
+    body.brackets = false;
+
+    for (size_t i = 0; i < n; i += chunk)
+    {
+      size_t len = n - i < chunk ? n - i : chunk;
+      char* pos = out;
+
+      if (i == 0 and fmt.brackets)
+      {
+        *pos++ = '[';
+      }
+      else if (i != 0 and fmt.separator != '\0')
+      {
+        *pos++ = fmt.separator;
+      }
+
+      pos += format_hex(pos, data + i, len, body);
+
+      if (i + len == n and fmt.brackets)
+      {
+        *pos++ = ']';
+      }
+
+      stream.write(out, pos - out);
+    }
+
+    return stream;
+  }
+}
@@ -0,0 +1,866 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2020 Kevin Xu
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <new>
+#include <ostream>
+#include <stdexcept>
+#include <utility>
+
+#include "shared_buf.hpp"
+#include "shared_buf_view.hpp"
+
+namespace xu
+{
+  /**
+    @brief  Reference count policy with plain, non-atomic arithmetic
+            Only for buffers whose every handle stays on one thread
+    */
+  struct local_count
+  {
+    using count_type = size_t;
+
+    static void acquire(count_type& count)
+    {
+      count++;
+    }
+
+    /**
+      @return Whether this was the last reference
+      */
+    static bool release(count_type& count)
+    {
+      return --count == 0;
+    }
+
+    static size_t load(const count_type& count)
+    {
+      return count;
+    }
+  };
+
+  /**
+    @brief  Reference count policy with atomic arithmetic, as in shared_ptr
+    */
+  struct atomic_count
+  {
+    using count_type = std::atomic<size_t>;
+
+    static void acquire(count_type& count)
+    {
+      count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+      @return Whether this was the last reference
+      @note   Acquire-release, so the last owner sees every other owner's writes before
+              freeing the bytes
+      */
+    static bool release(count_type& count)
+    {
+      return count.fetch_sub(1, std::memory_order_acq_rel) == 1;
+    }
+
+    static size_t load(const count_type& count)
+    {
+      return count.load(std::memory_order_acquire);
+    }
+  };
+
+  template<typename Count_T>
+  class basic_intrusive_slice;
+
+  namespace detail
+  {
+    /**
+      @brief  Allocation header, followed directly by the bytes
+      */
+    template<typename Count_T>
+    struct alignas(std::max_align_t) intrusive_header
+    {
+      typename Count_T::count_type count;
+      size_t sz;
+
+      uint8_t* data()
+      {
+        return reinterpret_cast<uint8_t*>(this + 1);
+      }
+
+      /**
+        @throw  std::bad_alloc
+                If the header and sz bytes cannot be allocated, or their size overflows
+        */
+      static intrusive_header* create(size_t sz)
+      {
+        if (sz > SIZE_MAX - sizeof(intrusive_header))
+        {
+          throw std::bad_alloc();
+        }
+        void* mem = ::operator new(sizeof(intrusive_header) + sz);
+        return ::new (mem) intrusive_header{{1}, sz};
+      }
+
+      static void destroy(intrusive_header* hdr)
+      {
+        hdr->~intrusive_header();
+        ::operator delete(hdr);
+      }
+
+      /**
+        @brief  Adds a reference, if hdr is not null
+        */
+      static void retain(intrusive_header* hdr)
+      {
+        if (hdr)
+        {
+          Count_T::acquire(hdr->count);
+        }
+      }
+
+      /**
+        @brief  Drops a reference, if hdr is not null, and frees with the last one
+        */
+      static void release(intrusive_header* hdr)
+      {
+        if (hdr and Count_T::release(hdr->count))
+        {
+          destroy(hdr);
+        }
+      }
+    };
+
+    /**
+      @brief  Deleter that lets a shared_ptr take over an intrusive allocation,
+              given a pointer to its first byte
+      */
+    template<typename Count_T>
+    struct intrusive_deleter
+    {
+      void operator()(uint8_t* bytes) const
+      {
+        using header = intrusive_header<Count_T>;
+        header::destroy(reinterpret_cast<header*>(bytes) - 1);
+      }
+    };
+  }
+
+  /**
+    @brief  Implements a shared buffer whose reference count and size live in a header in
+            front of the bytes, so a handle is a single pointer and copying one only touches
+            that header
+    @tparam Count_T
+            Reference count policy, e.g. local_count
+    */
+  template<typename Count_T>
+  class basic_intrusive_buf
+  {
+  public:
+    //  =========
+    //  Iterators
+    //  =========
+
+    using iterator = shared_buf::iterator;
+    using const_iterator = shared_buf::const_iterator;
+    using reverse_iterator = shared_buf::reverse_iterator;
+    using const_reverse_iterator = shared_buf::const_reverse_iterator;
+
+    iterator begin()
+    {
+      return shared_buf::makeIterator(data(), size(), 0);
+    }
+
+    iterator end()
+    {
+      return shared_buf::makeIterator(data(), size(), size());
+    }
+
+    const_iterator begin() const
+    {
+      return shared_buf::makeIterator(data(), size(), 0);
+    }
+
+    const_iterator end() const
+    {
+      return shared_buf::makeIterator(data(), size(), size());
+    }
+
+    const_iterator cbegin() const
+    {
+      return begin();
+    }
+
+    const_iterator cend() const
+    {
+      return end();
+    }
+
+    reverse_iterator rbegin()
+    {
+      return reverse_iterator(end());
+    }
+
+    reverse_iterator rend()
+    {
+      return reverse_iterator(begin());
+    }
+
+    const_reverse_iterator rbegin() const
+    {
+      return const_reverse_iterator(end());
+    }
+
+    const_reverse_iterator rend() const
+    {
+      return const_reverse_iterator(begin());
+    }
+
+    //  ================
+    //  Member Functions
+    //  ================
+
+    /**
+      @brief  Constructor
+      @param  sz_
+              Number of bytes in buffer
+      @note   Header and bytes come from a single allocation; bytes are left uninitialized
+      */
+    explicit basic_intrusive_buf(size_t sz_)
+      : hdr(header::create(sz_))
+    {
+
+    }
+
+    /**
+      @brief  Copy constructor, shares the bytes
+      */
+    basic_intrusive_buf(const basic_intrusive_buf& other)
+      : hdr(other.hdr)
+    {
+      header::retain(hdr);
+    }
+
+    /**
+      @brief  Move constructor
+      */
+    basic_intrusive_buf(basic_intrusive_buf&& other) noexcept
+      : hdr(std::exchange(other.hdr, nullptr))
+    {
+
+    }
+
+    /**
+      @brief  Copy assignment, shares the bytes
+      */
+    basic_intrusive_buf& operator=(const basic_intrusive_buf& other)
+    {
+      if (this != &other)
+      {
+        header::retain(other.hdr);
+        header::release(hdr);
+        hdr = other.hdr;
+      }
+
+      return *this;
+    }
+
+    /**
+      @brief  Move assignment
+      */
+    basic_intrusive_buf& operator=(basic_intrusive_buf&& other) noexcept
+    {
+      if (this != &other)
+      {
+        header::release(hdr);
+        hdr = std::exchange(other.hdr, nullptr);
+      }
+
+      return *this;
+    }
+
+    /**
+      @brief  Destructor, frees the bytes with the last reference
+      */
+    ~basic_intrusive_buf()
+    {
+      header::release(hdr);
+    }
+
+    /**
+      @brief  Byte access
+      @param  i
+              Index
+      @throw  std::out_of_range
+              If index is not within size, unless XU_SHARED_BUF_CHECK selects a
+              policy without exceptions
+      */
+    uint8_t& operator[](size_t i)
+    {
+      checkLive();
+      detail::checkIndex(i, size(), "basic_intrusive_buf::operator[] : index out of range");
+      return hdr->data()[i];
+    }
+
+    /**
+      @brief  Byte access, const-qualified
+      @see    operator[](size_t)
+      */
+    const uint8_t& operator[](size_t i) const
+    {
+      checkLive();
+      detail::checkIndex(i, size(), "basic_intrusive_buf::operator[] : index out of range");
+      return hdr->data()[i];
+    }
+
+    /**
+      @brief  Byte access, checked under every policy
+      @throw  std::out_of_range
+              If index is not within size
+      */
+    uint8_t& at(size_t i)
+    {
+      if (i >= size())
+      {
+        throw std::out_of_range("basic_intrusive_buf::at() : index out of range");
+      }
+      return hdr->data()[i];
+    }
+
+    /**
+      @brief  Byte access, checked under every policy, const-qualified
+      @throw  std::out_of_range
+              If index is not within size
+      */
+    const uint8_t& at(size_t i) const
+    {
+      if (i >= size())
+      {
+        throw std::out_of_range("basic_intrusive_buf::at() : index out of range");
+      }
+      return hdr->data()[i];
+    }
+
+    /**
+      @brief  Pointer access
+      @return First byte, or nullptr if moved from
+      */
+    uint8_t* data()
+    {
+      checkLive();
+      return hdr ? hdr->data() : nullptr;
+    }
+
+    /**
+      @brief  Pointer access, const-qualified
+      */
+    const uint8_t* data() const
+    {
+      checkLive();
+      return hdr ? hdr->data() : nullptr;
+    }
+
+    /**
+      @brief  Returns a read-only view of the bytes
+      */
+    operator shared_buf_view() const
+    {
+      return shared_buf_view(data(), size());
+    }
+
+    /**
+      @brief  Returns a handle to a window of this buffer
+              The window shares ownership of the allocation, so it keeps the allocation
+              alive even if this buffer is destroyed
+      @param  offset
+              Index of the first byte in the window
+      @param  length
+              Number of bytes in the window
+      @throw  std::out_of_range
+              If the window does not lie within size
+      @throw  std::length_error
+              If the window ends beyond 4 GiB, which a slice cannot address
+      */
+    basic_intrusive_slice<Count_T> slice(size_t offset, size_t length) const
+    {
+      checkLive();
+      if (offset > size() or length > size() - offset)
+      {
+        throw std::out_of_range("basic_intrusive_buf::slice() : window out of range");
+      }
+
+      header::retain(hdr);
+      return basic_intrusive_slice<Count_T>(hdr, offset, length);
+    }
+
+    /**
+      @brief  Returns a handle to the bytes from offset to the end of this buffer
+      @see    slice(size_t, size_t)
+      */
+    basic_intrusive_slice<Count_T> slice(size_t offset) const
+    {
+      if (offset > size())
+      {
+        throw std::out_of_range("basic_intrusive_buf::slice() : window out of range");
+      }
+
+      return slice(offset, size() - offset);
+    }
+
+    /**
+      @brief  Converts into a shared_buf, e.g. to hand the bytes to another thread, without
+              copying them
+              This buffer is left empty, as if moved from
+      @throw  std::logic_error
+              If other handles still share the bytes; their count would otherwise be
+              updated behind shared_buf's back
+      */
+    shared_buf share() &&
+    {
+      checkLive();
+      if (not hdr)
+      {
+        return shared_buf(0);
+      }
+      if (Count_T::load(hdr->count) != 1)
+      {
+        throw std::logic_error("basic_intrusive_buf::share() : buffer is not uniquely owned");
+      }
+
+      /*
+       *  shared_ptr frees a raw pointer if its control block cannot be allocated, but leaves
+       *  a unique_ptr untouched, so handing it one keeps this buffer intact on a throw
+       */
+      std::unique_ptr<uint8_t[], detail::intrusive_deleter<Count_T>> owned(hdr->data());
+      std::shared_ptr<uint8_t[]> shared;
+      try
+      {
+        shared = std::shared_ptr<uint8_t[]>(std::move(owned));
+      }
+      catch (...)
+      {
+        owned.release();
+        throw;
+      }
+
+      size_t shared_sz = std::exchange(hdr, nullptr)->sz;
+      return shared_buf(shared_sz, std::move(shared));
+    }
+
+    /**
+      @brief  Output to string
+      @param  fmt
+              Hex layout, [01,02,...] by default
+      */
+    std::ostream& print(std::ostream& stream, const hex_format& fmt = hex_format()) const
+    {
+      return print_hex(stream, data(), size(), fmt);
+    }
+
+    /**
+      @brief  Returns size
+      */
+    size_t size() const
+    {
+      return hdr ? hdr->sz : 0;
+    }
+
+    /**
+      @brief  Returns the number of handles sharing the bytes, 0 if moved from
+      */
+    size_t use_count() const
+    {
+      return hdr ? Count_T::load(hdr->count) : 0;
+    }
+
+  protected:
+    using header = detail::intrusive_header<Count_T>;
+
+    void checkLive() const
+    {
+      detail::checkLive(hdr, "basic_intrusive_buf : use of moved-from buffer");
+    }
+
+    //  ================
+    //  Member Variables
+    //  ================
+
+    header* hdr;
+  };
+
+  /**
+    @brief  Implements a window of an intrusive buffer
+            A header pointer plus a 32-bit offset and length, so a handle is two words
+            rather than shared_buf's three
+    @tparam Count_T
+            Reference count policy, as in the buffer sliced
+    */
+  template<typename Count_T>
+  class basic_intrusive_slice
+  {
+  public:
+    //  =========
+    //  Iterators
+    //  =========
+
+    using iterator = shared_buf::iterator;
+    using const_iterator = shared_buf::const_iterator;
+    using reverse_iterator = shared_buf::reverse_iterator;
+    using const_reverse_iterator = shared_buf::const_reverse_iterator;
+
+    iterator begin()
+    {
+      return shared_buf::makeIterator(data(), size(), 0);
+    }
+
+    iterator end()
+    {
+      return shared_buf::makeIterator(data(), size(), size());
+    }
+
+    const_iterator begin() const
+    {
+      return shared_buf::makeIterator(data(), size(), 0);
+    }
+
+    const_iterator end() const
+    {
+      return shared_buf::makeIterator(data(), size(), size());
+    }
+
+    const_iterator cbegin() const
+    {
+      return begin();
+    }
+
+    const_iterator cend() const
+    {
+      return end();
+    }
+
+    reverse_iterator rbegin()
+    {
+      return reverse_iterator(end());
+    }
+
+    reverse_iterator rend()
+    {
+      return reverse_iterator(begin());
+    }
+
+    const_reverse_iterator rbegin() const
+    {
+      return const_reverse_iterator(end());
+    }
+
+    const_reverse_iterator rend() const
+    {
+      return const_reverse_iterator(begin());
+    }
+
+    //  ================
+    //  Member Functions
+    //  ================
+
+    /**
+      @brief  Constructor, views a whole buffer
+      @throw  std::length_error
+              If the buffer is larger than 4 GiB
+      */
+    basic_intrusive_slice(const basic_intrusive_buf<Count_T>& buf)
+      : basic_intrusive_slice(buf.slice(0))
+    {
+
+    }
+
+    /**
+      @brief  Copy constructor, shares the bytes
+      */
+    basic_intrusive_slice(const basic_intrusive_slice& other)
+      : hdr(other.hdr),
+        off(other.off),
+        len(other.len)
+    {
+      header::retain(hdr);
+    }
+
+    /**
+      @brief  Move constructor
+      */
+    basic_intrusive_slice(basic_intrusive_slice&& other) noexcept
+      : hdr(std::exchange(other.hdr, nullptr)),
+        off(std::exchange(other.off, 0)),
+        len(std::exchange(other.len, 0))
+    {
+
+    }
+
+    /**
+      @brief  Copy assignment, shares the bytes
+      */
+    basic_intrusive_slice& operator=(const basic_intrusive_slice& other)
+    {
+      if (this != &other)
+      {
+        header::retain(other.hdr);
+        header::release(hdr);
+        hdr = other.hdr;
+        off = other.off;
+        len = other.len;
+      }
+
+      return *this;
+    }
+
+    /**
+      @brief  Move assignment
+      */
+    basic_intrusive_slice& operator=(basic_intrusive_slice&& other) noexcept
+    {
+      if (this != &other)
+      {
+        header::release(hdr);
+        hdr = std::exchange(other.hdr, nullptr);
+        off = std::exchange(other.off, 0);
+        len = std::exchange(other.len, 0);
+      }
+
+      return *this;
+    }
+
+    /**
+      @brief  Destructor, frees the bytes with the last reference
+      */
+    ~basic_intrusive_slice()
+    {
+      header::release(hdr);
+    }
+
+    /**
+      @brief  Byte access
+      @param  i
+              Index
+      @throw  std::out_of_range
+              If index is not within size, unless XU_SHARED_BUF_CHECK selects a
+              policy without exceptions
+      */
+    uint8_t& operator[](size_t i)
+    {
+      checkLive();
+      detail::checkIndex(i, len, "basic_intrusive_slice::operator[] : index out of range");
+      return data()[i];
+    }
+
+    /**
+      @brief  Byte access, const-qualified
+      @see    operator[](size_t)
+      */
+    const uint8_t& operator[](size_t i) const
+    {
+      checkLive();
+      detail::checkIndex(i, len, "basic_intrusive_slice::operator[] : index out of range");
+      return data()[i];
+    }
+
+    /**
+      @brief  Byte access, checked under every policy
+      @throw  std::out_of_range
+              If index is not within size
+      */
+    uint8_t& at(size_t i)
+    {
+      if (i >= len)
+      {
+        throw std::out_of_range("basic_intrusive_slice::at() : index out of range");
+      }
+      return data()[i];
+    }
+
+    /**
+      @brief  Byte access, checked under every policy, const-qualified
+      @throw  std::out_of_range
+              If index is not within size
+      */
+    const uint8_t& at(size_t i) const
+    {
+      if (i >= len)
+      {
+        throw std::out_of_range("basic_intrusive_slice::at() : index out of range");
+      }
+      return data()[i];
+    }
+
+    /**
+      @brief  Pointer access
+      @return First byte of the window, or nullptr if moved from
+      */
+    uint8_t* data()
+    {
+      checkLive();
+      return hdr ? hdr->data() + off : nullptr;
+    }
+
+    /**
+      @brief  Pointer access, const-qualified
+      */
+    const uint8_t* data() const
+    {
+      checkLive();
+      return hdr ? hdr->data() + off : nullptr;
+    }
+
+    /**
+      @brief  Returns a read-only view of the bytes
+      */
+    operator shared_buf_view() const
+    {
+      return shared_buf_view(data(), size());
+    }
+
+    /**
+      @brief  Returns a handle to a window of this one
+      @throw  std::out_of_range
+              If the window does not lie within size
+      @see    basic_intrusive_buf::slice(size_t, size_t)
+      */
+    basic_intrusive_slice slice(size_t offset, size_t length) const
+    {
+      checkLive();
+      if (offset > len or length > len - offset)
+      {
+        throw std::out_of_range("basic_intrusive_slice::slice() : window out of range");
+      }
+
+      header::retain(hdr);
+      return basic_intrusive_slice(hdr, off + offset, length);
+    }
+
+    /**
+      @brief  Returns a handle to the bytes from offset to the end of this one
+      @throw  std::out_of_range
+              If offset is greater than size
+      */
+    basic_intrusive_slice slice(size_t offset) const
+    {
+      if (offset > len)
+      {
+        throw std::out_of_range("basic_intrusive_slice::slice() : window out of range");
+      }
+
+      return slice(offset, len - offset);
+    }
+
+    /**
+      @brief  Output to string
+      @param  fmt
+              Hex layout, [01,02,...] by default
+      */
+    std::ostream& print(std::ostream& stream, const hex_format& fmt = hex_format()) const
+    {
+      return print_hex(stream, data(), size(), fmt);
+    }
+
+    /**
+      @brief  Returns size
+      */
+    size_t size() const
+    {
+      return len;
+    }
+
+    /**
+      @brief  Returns the number of handles sharing the allocation, 0 if moved from
+      */
+    size_t use_count() const
+    {
+      return hdr ? Count_T::load(hdr->count) : 0;
+    }
+
+  protected:
+    friend class basic_intrusive_buf<Count_T>;
+
+    using header = detail::intrusive_header<Count_T>;
+
+    /**
+      @brief  Constructor, adopts one reference to hdr, which may be null
+      @throw  std::length_error
+              If the window ends beyond 4 GiB
+      */
+    basic_intrusive_slice(header* hdr_, size_t off_, size_t len_)
+      : hdr(hdr_),
+        off((uint32_t)off_),
+        len((uint32_t)len_)
+    {
+      if (off_ + len_ > std::numeric_limits<uint32_t>::max())
+      {
+        header::release(hdr);
+        hdr = nullptr;
+        throw std::length_error("basic_intrusive_slice : window ends beyond 4 GiB");
+      }
+    }
+
+    void checkLive() const
+    {
+      detail::checkLive(hdr, "basic_intrusive_slice : use of moved-from buffer");
+    }
+
+    //  ================
+    //  Member Variables
+    //  ================
+
+    header* hdr;
+    uint32_t off;
+    uint32_t len;
+  };
+
+  /**
+    @brief  Thread-confined shared buffer: copies and destruction are plain increments and
+            decrements; use share() to hand the bytes to another thread
+    */
+  using local_shared_buf = basic_intrusive_buf<local_count>;
+  using local_shared_slice = basic_intrusive_slice<local_count>;
+
+  /**
+    @brief  Thread-safe shared buffer in a single pointer, for keeping very many handles in
+            queues and maps; slices of it take two words
+    */
+  using compact_shared_buf = basic_intrusive_buf<atomic_count>;
+  using compact_shared_slice = basic_intrusive_slice<atomic_count>;
+}
+
+template<typename Count_T>
+inline std::ostream& operator<<(std::ostream& stream, const xu::basic_intrusive_buf<Count_T>& buf)
+{
+  return buf.print(stream);
+}
+
+template<typename Count_T>
+inline std::ostream& operator<<(std::ostream& stream, const xu::basic_intrusive_slice<Count_T>& slice)
+{
+  return slice.print(stream);
+}
@@ -0,0 +1,254 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2020 Kevin Xu
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+#include <system_error>
+
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "shared_buf.hpp"
+#include "shared_buf_chain.hpp"
+
+namespace xu
+{
+  namespace detail
+  {
+    /* iovecs gathered on the stack per readv/writev call, further capped by IOV_MAX */
+    constexpr size_t iov_batch = 256;
+
+    inline size_t iovBatchSize()
+    {
+      static const size_t batch = []()
+      {
+        long iov_max = ::sysconf(_SC_IOV_MAX);
+#ifdef IOV_MAX
+        if (iov_max <= 0)
+        {
+          iov_max = IOV_MAX;
+        }
+#endif
+        if (iov_max <= 0)
+        {
+          iov_max = 16;
+        }
+        return std::min(iov_batch, (size_t)iov_max);
+      }();
+      return batch;
+    }
+
+    /**
+      @brief  Calls writev (Write == true) or readv until every iovec has been transferred
+      @note   Retries on EINTR and resumes after partial transfers
+      @return Bytes transferred, which is less than requested only on end of file or
+              if the descriptor is non-blocking and would block
+      @throw  std::system_error
+              On any other error
+      */
+    template<bool Write>
+    size_t transferv(int fd, struct iovec* iov, size_t count)
+    {
+      size_t total = 0;
+
+      while (count > 0)
+      {
+        ssize_t res = Write
+          ? ::writev(fd, iov, (int)count)
+          : ::readv(fd, iov, (int)count);
+
+        if (res < 0)
+        {
+          if (errno == EINTR)
+          {
+            continue;
+          }
+          if (errno == EAGAIN or errno == EWOULDBLOCK)
+          {
+            break;
+          }
+          throw std::system_error(errno, std::generic_category(),
+            Write ? "xu::write_to" : "xu::read_from");
+        }
+
+        if (res == 0)
+        {
+          break;
+        }
+
+        total += res;
+
+        /* skip fully transferred iovecs, and trim the partially transferred one */
+        size_t left = res;
+        while (count > 0 and left >= iov->iov_len)
+        {
+          left -= iov->iov_len;
+          iov++;
+          count--;
+        }
+        if (left > 0)
+        {
+          iov->iov_base = (uint8_t*)iov->iov_base + left;
+          iov->iov_len -= left;
+        }
+      }
+
+      return total;
+    }
+
+    /**
+      @brief  Gathers buffers from [first, last) into batches of iovecs and transfers them
+      */
+    template<bool Write, typename It>
+    size_t transferRange(int fd, It first, It last)
+    {
+      struct iovec iov[iov_batch];
+      const size_t batch = iovBatchSize();
+
+      size_t total = 0;
+
+      while (first != last)
+      {
+        size_t n = 0;
+        size_t want = 0;
+        for (; first != last and n < batch; ++first)
+        {
+          if (first->size() == 0)
+          {
+            continue;
+          }
+          iov[n].iov_base = const_cast<uint8_t*>(first->data());
+          iov[n].iov_len = first->size();
+          want += first->size();
+          n++;
+        }
+
+        size_t done = transferv<Write>(fd, iov, n);
+        total += done;
+
+        if (done < want)
+        {
+          break;
+        }
+      }
+
+      return total;
+    }
+  }
+
+  /**
+    @brief  Writes a whole buffer to a file descriptor
+    @return Bytes written, which is less than size only if fd is non-blocking and would block
+    @throw  std::system_error
+            On write error
+    */
+  inline size_t write_to(int fd, const shared_buf& buf)
+  {
+    struct iovec iov = {const_cast<uint8_t*>(buf.data()), buf.size()};
+    return buf.size() == 0 ? 0 : detail::transferv<true>(fd, &iov, 1);
+  }
+
+  /**
+    @brief  Fills a whole buffer from a file descriptor
+    @return Bytes read, which is less than size on end of file, or if fd is non-blocking
+            and would block
+    @throw  std::system_error
+            On read error
+    */
+  inline size_t read_from(int fd, shared_buf& buf)
+  {
+    struct iovec iov = {buf.data(), buf.size()};
+    return buf.size() == 0 ? 0 : detail::transferv<false>(fd, &iov, 1);
+  }
+
+  /**
+    @brief  Writes a sequence of buffers to a file descriptor, using as few writev calls as
+            IOV_MAX allows
+    @return Bytes written, which is less than the total only if fd is non-blocking and would block
+    @throw  std::system_error
+            On write error
+    */
+  template<typename It>
+  size_t write_to(int fd, It first, It last)
+  {
+    return detail::transferRange<true>(fd, first, last);
+  }
+
+  /**
+    @brief  Fills a sequence of buffers from a file descriptor, using as few readv calls as
+            IOV_MAX allows
+    @return Bytes read, which is less than the total on end of file, or if fd is non-blocking
+            and would block
+    @throw  std::system_error
+            On read error
+    */
+  template<typename It>
+  size_t read_from(int fd, It first, It last)
+  {
+    return detail::transferRange<false>(fd, first, last);
+  }
+
+  /**
+    @brief  Writes a container of buffers to a file descriptor
+    @see    write_to(int, It, It)
+    */
+  template<typename Seq_T>
+  size_t write_to(int fd, const Seq_T& bufs)
+  {
+    return write_to(fd, std::begin(bufs), std::end(bufs));
+  }
+
+  /**
+    @brief  Fills a container of buffers from a file descriptor
+    @see    read_from(int, It, It)
+    */
+  template<typename Seq_T>
+  size_t read_from(int fd, Seq_T& bufs)
+  {
+    return read_from(fd, std::begin(bufs), std::end(bufs));
+  }
+
+  /**
+    @brief  Writes every segment of a chain to a file descriptor
+    @see    write_to(int, It, It)
+    */
+  inline size_t write_to(int fd, const shared_buf_chain& chain)
+  {
+    return write_to(fd, chain.segments().begin(), chain.segments().end());
+  }
+
+  /**
+    @brief  Fills every segment of a chain from a file descriptor
+    @note   Segments share their bytes, so this writes into the buffers the chain refers to
+    @see    read_from(int, It, It)
+    */
+  inline size_t read_from(int fd, shared_buf_chain& chain)
+  {
+    return read_from(fd, chain.segments().begin(), chain.segments().end());
+  }
+}
@@ -0,0 +1,164 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2020 Kevin Xu
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#pragma once
+
+#include <cerrno>
+#include <cstdint>
+#include <string>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "shared_buf.hpp"
+
+namespace xu
+{
+  enum class map_advice
+  {
+    normal,
+    sequential,
+    random,
+    willneed
+  };
+
+  struct map_options
+  {
+    /* if true, the mapping is MAP_PRIVATE and writable; writes are never seen in the file */
+    bool writable = false;
+    /* prefault the whole mapping (MAP_POPULATE) */
+    bool populate = false;
+    /* hint passed to madvise() */
+    map_advice advice = map_advice::normal;
+    /* first byte of the file to map */
+    size_t offset = 0;
+    /* number of bytes to map, 0 meaning up to the end of the file */
+    size_t length = 0;
+  };
+
+  namespace detail
+  {
+    inline int toMadvise(map_advice advice)
+    {
+      switch (advice)
+      {
+        case map_advice::sequential:
+          return MADV_SEQUENTIAL;
+        case map_advice::random:
+          return MADV_RANDOM;
+        case map_advice::willneed:
+          return MADV_WILLNEED;
+        default:
+          return MADV_NORMAL;
+      }
+    }
+
+    inline size_t pageSize()
+    {
+      static const size_t page = (size_t)::sysconf(_SC_PAGESIZE);
+      return page;
+    }
+  }
+
+  /**
+    @brief  Maps a file into memory and wraps it in a shared buffer
+            The mapping is removed when the last reference is dropped
+    @param  path
+            File to map
+    @param  opts
+            Access mode, prefaulting, madvise hint and range
+    @note   Unless opts.writable is set, the mapping is read-only and writing through the
+            buffer raises SIGSEGV
+    @throw  std::system_error
+            If the file cannot be opened, inspected or mapped
+    @throw  std::out_of_range
+            If the requested range does not lie within the file
+    */
+  inline shared_buf map_file(const std::string& path, const map_options& opts = map_options())
+  {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+      throw std::system_error(errno, std::generic_category(), "xu::map_file: open " + path);
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0)
+    {
+      int err = errno;
+      ::close(fd);
+      throw std::system_error(err, std::generic_category(), "xu::map_file: fstat " + path);
+    }
+
+    size_t file_sz = (size_t)st.st_size;
+    if (opts.offset > file_sz or opts.length > file_sz - opts.offset)
+    {
+      ::close(fd);
+      throw std::out_of_range("xu::map_file : range out of file");
+    }
+
+    size_t sz = opts.length != 0 ? opts.length : file_sz - opts.offset;
+    if (sz == 0)
+    {
+      ::close(fd);
+      return shared_buf(0);
+    }
+
+    /* mmap offsets must be page-aligned */
+    size_t map_offset = opts.offset - opts.offset % detail::pageSize();
+    size_t lead = opts.offset - map_offset;
+    size_t map_len = lead + sz;
+
+    int prot = PROT_READ | (opts.writable ? PROT_WRITE : 0);
+    int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+    if (opts.populate)
+    {
+      flags |= MAP_POPULATE;
+    }
+#endif
+
+    void* base = ::mmap(nullptr, map_len, prot, flags, fd, (off_t)map_offset);
+    int err = errno;
+    ::close(fd);
+
+    if (base == MAP_FAILED)
+    {
+      throw std::system_error(err, std::generic_category(), "xu::map_file: mmap " + path);
+    }
+
+    if (opts.advice != map_advice::normal)
+    {
+      /* a hint only, so failure is not an error */
+      ::madvise(base, map_len, detail::toMadvise(opts.advice));
+    }
+
+    uint8_t* data = (uint8_t*)base + lead;
+    return shared_buf(sz, std::shared_ptr<uint8_t[]>(data,
+      detail::munmap_deleter{base, map_len, not opts.writable}));
+  }
+}
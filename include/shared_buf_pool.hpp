@@ -0,0 +1,763 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2020 Kevin Xu
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#pragma once
+
+#if __cplusplus < 202002L
+#error "shared_buf_pool.hpp requires C++20"
+#endif
+
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#include "shared_buf.hpp"
+
+namespace xu
+{
+  namespace detail
+  {
+    struct pool_node
+    {
+      pool_node* next;
+    };
+
+    /**
+      @brief  Counter written only by its owning thread, but readable from any thread
+      @note   Uses a plain load/store pair instead of a read-modify-write, since there
+              is only a single writer
+      */
+    class pool_counter
+    {
+    public:
+      void bump()
+      {
+        v.store(v.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+      }
+
+      uint64_t get() const
+      {
+        return v.load(std::memory_order_relaxed);
+      }
+
+    protected:
+      std::atomic<uint64_t> v{0};
+    };
+
+    /**
+      @brief  Per-thread cache ("magazines") of free blocks, one bin per size class
+      */
+    struct pool_thread_cache
+    {
+      struct bin
+      {
+        pool_node* head = nullptr;
+        size_t count = 0;
+      };
+
+      pool_thread_cache(size_t num_classes, size_t min_shift_)
+        : bins(num_classes),
+          min_shift(min_shift_)
+      {}
+
+      /**
+        @brief  Frees every cached block, once the pool they came from is gone
+        */
+      void drop()
+      {
+        for (size_t c = 0; c < bins.size(); c++)
+        {
+          while (bins[c].head != nullptr)
+          {
+            pool_node* next = bins[c].head->next;
+            ::operator delete(bins[c].head, size_t(1) << (c + min_shift));
+            bins[c].head = next;
+          }
+          bins[c].count = 0;
+        }
+      }
+
+      std::vector<bin> bins;
+      size_t min_shift;
+
+      pool_counter allocations;
+      pool_counter deallocations;
+      pool_counter cache_hits;
+      pool_counter depot_hits;
+      pool_counter system_allocations;
+      pool_counter oversize_allocations;
+    };
+  }
+
+  /**
+    @brief  Size-class pool for buffer storage
+            Each thread keeps a small cache of free blocks per size class; caches
+            exchange whole magazines of blocks with a shared, mutex-protected depot
+    @note   Buffers made from a pool must not outlive it
+    */
+  class buf_pool
+  {
+  public:
+    struct config
+    {
+      /* smallest size class, rounded up to a power of two */
+      size_t min_block = 64;
+      /* largest size class, rounded up to a power of two; larger requests bypass the pool */
+      size_t max_block = 65536;
+      /* number of blocks moved between a thread cache and the depot at once */
+      size_t magazine_size = 32;
+    };
+
+    struct stats
+    {
+      uint64_t allocations = 0;
+      uint64_t deallocations = 0;
+      /* allocations served from the calling thread's cache */
+      uint64_t cache_hits = 0;
+      /* allocations that refilled the thread cache from the depot */
+      uint64_t depot_hits = 0;
+      /* allocations that fell through to operator new */
+      uint64_t system_allocations = 0;
+      /* allocations larger than max_block */
+      uint64_t oversize_allocations = 0;
+      /* bytes held in the depot */
+      size_t depot_bytes = 0;
+    };
+
+  protected:
+    class core : public std::enable_shared_from_this<core>
+    {
+    public:
+      explicit core(const config& cfg_)
+        : id(nextId()),
+          cfg(cfg_)
+      {
+        if (cfg.min_block < sizeof(detail::pool_node))
+        {
+          cfg.min_block = sizeof(detail::pool_node);
+        }
+        cfg.min_block = std::bit_ceil(cfg.min_block);
+        cfg.max_block = std::bit_ceil(cfg.max_block < cfg.min_block ? cfg.min_block : cfg.max_block);
+        if (cfg.magazine_size == 0)
+        {
+          cfg.magazine_size = 1;
+        }
+
+        min_shift = std::countr_zero(cfg.min_block);
+        num_classes = std::countr_zero(cfg.max_block) - min_shift + 1;
+        depot = std::make_unique<depot_bin[]>(num_classes);
+      }
+
+      ~core()
+      {
+        for (size_t c = 0; c < num_classes; c++)
+        {
+          for (auto& mag : depot[c].magazines)
+          {
+            freeList(mag.head, blockSize(c));
+          }
+        }
+      }
+
+      void* allocate(size_t n)
+      {
+        detail::pool_thread_cache* found = threadCache();
+        if (found == nullptr)
+        {
+          countUncached(true, n > cfg.max_block);
+          return ::operator new(n > cfg.max_block ? n : blockSize(classOf(n)));
+        }
+
+        detail::pool_thread_cache& cache = *found;
+        cache.allocations.bump();
+
+        if (n > cfg.max_block)
+        {
+          cache.oversize_allocations.bump();
+          return ::operator new(n);
+        }
+
+        size_t c = classOf(n);
+        auto& bin = cache.bins[c];
+
+        if (bin.head == nullptr)
+        {
+          depot_bin& d = depot[c];
+          std::lock_guard<std::mutex> lock(d.m);
+          if (not d.magazines.empty())
+          {
+            bin.head = d.magazines.back().head;
+            bin.count = d.magazines.back().count;
+            d.magazines.pop_back();
+            cache.depot_hits.bump();
+          }
+        }
+        else
+        {
+          cache.cache_hits.bump();
+        }
+
+        if (bin.head == nullptr)
+        {
+          cache.system_allocations.bump();
+          return ::operator new(blockSize(c));
+        }
+
+        detail::pool_node* node = bin.head;
+        bin.head = node->next;
+        bin.count--;
+        return node;
+      }
+
+      void deallocate(void* p, size_t n)
+      {
+        detail::pool_thread_cache* found = threadCache();
+        if (found == nullptr)
+        {
+          countUncached(false, false);
+          if (n > cfg.max_block)
+          {
+            ::operator delete(p);
+          }
+          else
+          {
+            ::operator delete(p, blockSize(classOf(n)));
+          }
+          return;
+        }
+
+        if (n > cfg.max_block)
+        {
+          found->deallocations.bump();
+          ::operator delete(p);
+          return;
+        }
+
+        detail::pool_thread_cache& cache = *found;
+        cache.deallocations.bump();
+
+        size_t c = classOf(n);
+        auto& bin = cache.bins[c];
+
+        if (bin.count >= 2 * cfg.magazine_size)
+        {
+          /* hand a full magazine to the depot, keeping the rest warm */
+          detail::pool_node* head = bin.head;
+          detail::pool_node* tail = head;
+          for (size_t i = 1; i < cfg.magazine_size; i++)
+          {
+            tail = tail->next;
+          }
+          bin.head = tail->next;
+          bin.count -= cfg.magazine_size;
+          tail->next = nullptr;
+
+          depot_bin& d = depot[c];
+          std::lock_guard<std::mutex> lock(d.m);
+          d.magazines.push_back({head, cfg.magazine_size});
+        }
+
+        auto* node = static_cast<detail::pool_node*>(p);
+        node->next = bin.head;
+        bin.head = node;
+        bin.count++;
+      }
+
+      /**
+        @brief  Returns the calling thread's cached blocks and all depot blocks to the system
+        */
+      void trim()
+      {
+        if (detail::pool_thread_cache* cache = findThreadCache())
+        {
+          flush(*cache);
+        }
+
+        for (size_t c = 0; c < num_classes; c++)
+        {
+          std::vector<magazine> mags;
+          {
+            std::lock_guard<std::mutex> lock(depot[c].m);
+            mags.swap(depot[c].magazines);
+          }
+          for (auto& mag : mags)
+          {
+            freeList(mag.head, blockSize(c));
+          }
+        }
+      }
+
+      /**
+        @brief  Retires the calling thread's cache and removes it from the thread's registry
+        */
+      void detachThread()
+      {
+        if (not registryAlive())
+        {
+          return;
+        }
+
+        registry& reg = threadRegistry();
+        for (auto it = reg.entries.begin(); it != reg.entries.end(); it++)
+        {
+          if (it->id == id)
+          {
+            retire(*it->cache);
+            reg.entries.erase(it);
+            break;
+          }
+        }
+
+        if (reg.last_id == id)
+        {
+          reg.last_id = 0;
+          reg.last_cache = nullptr;
+        }
+      }
+
+      stats getStats()
+      {
+        stats res;
+        {
+          std::lock_guard<std::mutex> lock(caches_m);
+          res = retired;
+          for (auto* cache : caches)
+          {
+            addCounters(res, *cache);
+          }
+        }
+
+        for (size_t c = 0; c < num_classes; c++)
+        {
+          std::lock_guard<std::mutex> lock(depot[c].m);
+          for (auto& mag : depot[c].magazines)
+          {
+            res.depot_bytes += mag.count * blockSize(c);
+          }
+        }
+
+        return res;
+      }
+
+    protected:
+      struct magazine
+      {
+        detail::pool_node* head;
+        size_t count;
+      };
+
+      struct depot_bin
+      {
+        std::mutex m;
+        std::vector<magazine> magazines;
+      };
+
+      /**
+        @brief  Thread-local list of the caches a thread owns, one per live pool it has used
+        @note   Entries are keyed by a pool id rather than its address, which a later pool
+                may reuse. They hold the core weakly: ~buf_pool removes its entry on the
+                destroying thread, and other threads drop the entries of dead pools, and free
+                the blocks cached in them, the next time they look a cache up or exit.
+                Once a thread's registry is destroyed, which for the main thread happens
+                before pools and buffers with static storage duration go, that thread
+                allocates and frees straight from the system
+        */
+      struct registry
+      {
+        struct entry
+        {
+          uint64_t id;
+          std::weak_ptr<core> owner;
+          std::unique_ptr<detail::pool_thread_cache> cache;
+        };
+
+        std::vector<entry> entries;
+        uint64_t last_id = 0;
+        detail::pool_thread_cache* last_cache = nullptr;
+
+        ~registry()
+        {
+          registryAlive() = false;
+          for (auto& e : entries)
+          {
+            if (std::shared_ptr<core> owner = e.owner.lock())
+            {
+              owner->retire(*e.cache);
+            }
+            else
+            {
+              e.cache->drop();
+            }
+          }
+        }
+      };
+
+      static registry& threadRegistry()
+      {
+        static thread_local registry reg;
+        return reg;
+      }
+
+      /**
+        @brief  Returns whether the calling thread's registry is usable; a plain flag, so
+                that it can still be read after the registry itself is destroyed
+        */
+      static bool& registryAlive()
+      {
+        static thread_local bool alive = true;
+        return alive;
+      }
+
+      static uint64_t nextId()
+      {
+        static std::atomic<uint64_t> ids{0};
+        return ids.fetch_add(1, std::memory_order_relaxed) + 1;
+      }
+
+      detail::pool_thread_cache* findThreadCache()
+      {
+        if (not registryAlive())
+        {
+          return nullptr;
+        }
+
+        registry& reg = threadRegistry();
+        if (reg.last_id == id)
+        {
+          return reg.last_cache;
+        }
+
+        detail::pool_thread_cache* found = nullptr;
+        for (size_t i = 0; i < reg.entries.size(); )
+        {
+          auto& e = reg.entries[i];
+          if (e.id == id)
+          {
+            found = e.cache.get();
+          }
+          else if (e.owner.expired())
+          {
+            e.cache->drop();
+            if (reg.last_id == e.id)
+            {
+              reg.last_id = 0;
+              reg.last_cache = nullptr;
+            }
+            e = std::move(reg.entries.back());
+            reg.entries.pop_back();
+            continue;
+          }
+          i++;
+        }
+
+        if (found != nullptr)
+        {
+          reg.last_id = id;
+          reg.last_cache = found;
+        }
+        return found;
+      }
+
+      /**
+        @brief  Returns the calling thread's cache, creating it on first use
+        @return Cache, or nullptr once the thread's registry is destroyed
+        */
+      detail::pool_thread_cache* threadCache()
+      {
+        if (detail::pool_thread_cache* cache = findThreadCache())
+        {
+          return cache;
+        }
+        if (not registryAlive())
+        {
+          return nullptr;
+        }
+
+        registry& reg = threadRegistry();
+        auto cache = std::make_unique<detail::pool_thread_cache>(num_classes, min_shift);
+        {
+          std::lock_guard<std::mutex> lock(caches_m);
+          caches.push_back(cache.get());
+        }
+        reg.entries.push_back({id, weak_from_this(), std::move(cache)});
+        reg.last_id = id;
+        reg.last_cache = reg.entries.back().cache.get();
+        return reg.last_cache;
+      }
+
+      /**
+        @brief  Counts an allocation or deallocation that bypassed the thread caches
+        */
+      void countUncached(bool allocation, bool oversize)
+      {
+        std::lock_guard<std::mutex> lock(caches_m);
+        if (allocation)
+        {
+          retired.allocations++;
+          retired.system_allocations++;
+          retired.oversize_allocations += oversize ? 1 : 0;
+        }
+        else
+        {
+          retired.deallocations++;
+        }
+      }
+
+      /**
+        @brief  Moves every block in a thread cache to the depot
+        */
+      void flush(detail::pool_thread_cache& cache)
+      {
+        for (size_t c = 0; c < num_classes; c++)
+        {
+          auto& bin = cache.bins[c];
+          if (bin.head != nullptr)
+          {
+            std::lock_guard<std::mutex> lock(depot[c].m);
+            depot[c].magazines.push_back({bin.head, bin.count});
+          }
+          bin.head = nullptr;
+          bin.count = 0;
+        }
+      }
+
+      /**
+        @brief  Called on thread exit
+        */
+      void retire(detail::pool_thread_cache& cache)
+      {
+        flush(cache);
+
+        std::lock_guard<std::mutex> lock(caches_m);
+        addCounters(retired, cache);
+        for (auto it = caches.begin(); it != caches.end(); it++)
+        {
+          if (*it == &cache)
+          {
+            caches.erase(it);
+            break;
+          }
+        }
+      }
+
+      static void addCounters(stats& res, const detail::pool_thread_cache& cache)
+      {
+        res.allocations += cache.allocations.get();
+        res.deallocations += cache.deallocations.get();
+        res.cache_hits += cache.cache_hits.get();
+        res.depot_hits += cache.depot_hits.get();
+        res.system_allocations += cache.system_allocations.get();
+        res.oversize_allocations += cache.oversize_allocations.get();
+      }
+
+      static void freeList(detail::pool_node* head, size_t block_size)
+      {
+        while (head != nullptr)
+        {
+          detail::pool_node* next = head->next;
+          ::operator delete(head, block_size);
+          head = next;
+        }
+      }
+
+      size_t classOf(size_t n) const
+      {
+        if (n <= cfg.min_block)
+        {
+          return 0;
+        }
+        return std::bit_width(n - 1) - min_shift;
+      }
+
+      size_t blockSize(size_t c) const
+      {
+        return size_t(1) << (c + min_shift);
+      }
+
+      /* unique for the life of the process, unlike the address */
+      uint64_t id;
+      config cfg;
+      size_t min_shift;
+      size_t num_classes;
+      std::unique_ptr<depot_bin[]> depot;
+
+      std::mutex caches_m;
+      std::vector<detail::pool_thread_cache*> caches;
+      stats retired;
+    };
+
+  public:
+    /**
+      @brief  Allocator drawing from a buf_pool, usable with std::allocate_shared
+      */
+    template<typename T>
+    class allocator
+    {
+    public:
+      using value_type = T;
+
+      static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__,
+        "buf_pool::allocator : over-aligned types are not supported");
+
+      allocator(buf_pool& pool)
+        : c(pool.c.get())
+      {}
+
+      template<typename U>
+      allocator(const allocator<U>& other)
+        : c(other.c)
+      {}
+
+      T* allocate(size_t n)
+      {
+        return static_cast<T*>(c->allocate(n * sizeof(T)));
+      }
+
+      void deallocate(T* p, size_t n)
+      {
+        c->deallocate(p, n * sizeof(T));
+      }
+
+      template<typename U>
+      bool operator==(const allocator<U>& other) const
+      {
+        return c == other.c;
+      }
+
+      template<typename U>
+      bool operator!=(const allocator<U>& other) const
+      {
+        return c != other.c;
+      }
+
+    protected:
+      template<typename U>
+      friend class allocator;
+
+      core* c;
+    };
+
+    /**
+      @brief  Constructor, using the default configuration
+      */
+    buf_pool()
+      : c(std::make_shared<core>(config()))
+    {
+
+    }
+
+    /**
+      @brief  Constructor
+      @param  cfg
+              Size classes and magazine size
+      */
+    explicit buf_pool(const config& cfg)
+      : c(std::make_shared<core>(cfg))
+    {
+
+    }
+
+    buf_pool(const buf_pool&) = delete;
+    buf_pool& operator=(const buf_pool&) = delete;
+
+    /**
+      @brief  Destructor
+      @note   Blocks cached by other threads are released when those threads next use
+              any pool, or exit
+      */
+    ~buf_pool()
+    {
+      c->detachThread();
+      c->trim();
+    }
+
+    /**
+      @brief  Creates a shared buffer whose control block and bytes are drawn from the pool
+              When the last reference is dropped, the block returns to the pool
+      @param  sz
+              Number of bytes in buffer
+      */
+    shared_buf make(size_t sz)
+    {
+#if defined(__cpp_lib_smart_ptr_for_overwrite)
+      return shared_buf(sz, std::allocate_shared_for_overwrite<uint8_t[]>(allocator<uint8_t>(*this), sz));
+#else
+      return shared_buf(sz, std::allocate_shared<uint8_t[]>(allocator<uint8_t>(*this), sz));
+#endif
+    }
+
+    /**
+      @brief  Raw block allocation
+      */
+    void* allocate(size_t n)
+    {
+      return c->allocate(n);
+    }
+
+    /**
+      @brief  Raw block deallocation
+      @param  n
+              Must match the size passed to allocate()
+      */
+    void deallocate(void* p, size_t n)
+    {
+      c->deallocate(p, n);
+    }
+
+    /**
+      @brief  Releases the calling thread's cached blocks and all depot blocks to the system
+      */
+    void trim()
+    {
+      c->trim();
+    }
+
+    /**
+      @brief  Returns counters aggregated over all threads
+      */
+    stats getStats() const
+    {
+      return c->getStats();
+    }
+
+  protected:
+    std::shared_ptr<core> c;
+  };
+
+  /**
+    @brief  Creates a shared buffer drawn from a pool
+    @param  sz
+            Number of bytes in buffer
+    @param  pool
+            Pool supplying the storage; must outlive the buffer
+    */
+  inline shared_buf make_shared_buf(size_t sz, buf_pool& pool)
+  {
+    return pool.make(sz);
+  }
+}
@@ -0,0 +1,221 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2020 Kevin Xu
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#pragma once
+
+#if __cplusplus < 202002L
+#error "shared_buf_queue.hpp requires C++20"
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+
+#include "shared_buf.hpp"
+
+namespace xu
+{
+  /**
+    @brief  Bounded lock-free multi-producer, multi-consumer queue of shared buffers
+            Each slot carries a sequence number that tells producers and consumers whose turn
+            it is (D. Vyukov's bounded MPMC queue), so a push or pop is one CAS on a shared
+            position plus a store to the slot. Buffers are moved in and out, so the queue
+            never touches their reference counts
+    */
+  class buf_queue
+  {
+  public:
+    static constexpr size_t cache_line = 64;
+
+    //  ================
+    //  Member Functions
+    //  ================
+
+    /**
+      @brief  Constructor
+      @param  capacity
+              Maximum number of buffers queued, rounded up to a power of two
+      */
+    explicit buf_queue(size_t capacity)
+      : mask(std::bit_ceil(std::max(capacity, size_t(2))) - 1),
+        slots(new slot[mask + 1])
+    {
+      for (size_t i = 0; i <= mask; i++)
+      {
+        slots[i].seq.store(i, std::memory_order_relaxed);
+      }
+    }
+
+    buf_queue(const buf_queue&) = delete;
+    buf_queue& operator=(const buf_queue&) = delete;
+
+    /**
+      @brief  Destructor, destroys buffers still queued
+      @note   No other thread may be using the queue
+      */
+    ~buf_queue()
+    {
+      shared_buf buf(0, nullptr);
+      while (tryPop(buf))
+      {
+
+      }
+    }
+
+    /**
+      @brief  Moves a buffer into the queue, if there is room
+      @return False if the queue is full, in which case buf is left untouched
+      */
+    bool tryPush(shared_buf&& buf)
+    {
+      return tryPushBatch(&buf, 1) == 1;
+    }
+
+    /**
+      @brief  Moves the oldest buffer out of the queue, if any
+      @return False if the queue is empty
+      */
+    bool tryPop(shared_buf& buf)
+    {
+      return tryPopBatch(&buf, 1) == 1;
+    }
+
+    /**
+      @brief  Moves up to n buffers into the queue, claiming their slots with a single CAS
+      @return Number of buffers pushed, from the front of bufs; the rest are left untouched
+      */
+    size_t tryPushBatch(shared_buf* bufs, size_t n)
+    {
+      size_t pos;
+      size_t count = claim(enqueue_pos.pos, n, 0, pos);
+
+      for (size_t i = 0; i < count; i++)
+      {
+        slot& s = slots[(pos + i) & mask];
+        ::new (s.storage) shared_buf(std::move(bufs[i]));
+        s.seq.store(pos + i + 1, std::memory_order_release);
+      }
+      return count;
+    }
+
+    /**
+      @brief  Moves up to n of the oldest buffers out of the queue, claiming their slots with
+              a single CAS
+      @return Number of buffers popped into the front of bufs
+      */
+    size_t tryPopBatch(shared_buf* bufs, size_t n)
+    {
+      size_t pos;
+      size_t count = claim(dequeue_pos.pos, n, 1, pos);
+
+      for (size_t i = 0; i < count; i++)
+      {
+        slot& s = slots[(pos + i) & mask];
+        shared_buf* queued = std::launder(reinterpret_cast<shared_buf*>(s.storage));
+        bufs[i] = std::move(*queued);
+        queued->~shared_buf();
+        s.seq.store(pos + i + mask + 1, std::memory_order_release);
+      }
+      return count;
+    }
+
+    /**
+      @brief  Returns the maximum number of buffers queued
+      */
+    size_t capacity() const
+    {
+      return mask + 1;
+    }
+
+  protected:
+    struct slot
+    {
+      /* pos when free for the push at pos, pos + 1 when filled by it */
+      std::atomic<size_t> seq;
+      alignas(shared_buf) unsigned char storage[sizeof(shared_buf)];
+    };
+
+    struct alignas(cache_line) position
+    {
+      std::atomic<size_t> pos{0};
+    };
+
+    /**
+      @brief  Claims up to n consecutive slots that are ready, i.e. whose sequence is their
+              position plus lag, by advancing shared_pos past them
+      @param  first
+              Set to the position of the first slot claimed
+      @return Number of slots claimed, 0 if the first is not ready
+      */
+    size_t claim(std::atomic<size_t>& shared_pos, size_t n, size_t lag, size_t& first)
+    {
+      size_t pos = shared_pos.load(std::memory_order_relaxed);
+      while (true)
+      {
+        size_t count = 0;
+        intptr_t diff = 0;
+        while (count < n)
+        {
+          size_t seq = slots[(pos + count) & mask].seq.load(std::memory_order_acquire);
+          diff = (intptr_t)(seq - (pos + count + lag));
+          if (diff != 0)
+          {
+            break;
+          }
+          count++;
+        }
+
+        if (count == 0)
+        {
+          if (diff < 0)
+          {
+            /* full, for a push; empty, for a pop */
+            return 0;
+          }
+          /* another thread claimed pos first */
+          pos = shared_pos.load(std::memory_order_relaxed);
+        }
+        else if (shared_pos.compare_exchange_weak(pos, pos + count, std::memory_order_relaxed))
+        {
+          first = pos;
+          return count;
+        }
+      }
+    }
+
+    //  ================
+    //  Member Variables
+    //  ================
+
+    size_t mask;
+    std::unique_ptr<slot[]> slots;
+    position enqueue_pos;
+    position dequeue_pos;
+  };
+}
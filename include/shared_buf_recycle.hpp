@@ -0,0 +1,389 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2020 Kevin Xu
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <vector>
+
+#include "shared_buf.hpp"
+
+namespace xu
+{
+  /**
+    @brief  Pool of identical-size blocks that buffers return to when their last reference
+            is dropped
+            Each block also holds the buffer's shared_ptr control block, so making and
+            dropping a buffer allocates nothing once the pool is warm. Reuse is LIFO, so the
+            block handed out next is the one freed most recently and most likely still in cache
+    @note   Buffers made from a pool must not outlive it
+    */
+  class recycling_pool
+  {
+  public:
+    struct config
+    {
+      /* size of every block, e.g. a 9 KiB jumbo frame */
+      size_t block_size = 9216;
+      /* most bytes kept on the free list; blocks freed beyond it go back to the system */
+      size_t max_pooled_bytes = size_t(64) << 20;
+      /* blocks allocated up front */
+      size_t prefill = 0;
+    };
+
+    struct stats
+    {
+      uint64_t allocations = 0;
+      /* allocations served from the free list */
+      uint64_t hits = 0;
+      /* allocations that fell through to operator new */
+      uint64_t misses = 0;
+      /* blocks returned to the free list */
+      uint64_t recycled = 0;
+      /* blocks freed because the free list was at max_pooled_bytes */
+      uint64_t discarded = 0;
+      /* bytes held on the free list */
+      size_t pooled_bytes = 0;
+
+      /**
+        @brief  Returns the fraction of allocations served from the free list
+        */
+      double hitRate() const
+      {
+        return allocations == 0 ? 0 : (double)hits / allocations;
+      }
+    };
+
+  protected:
+    /* alignment of blocks, so that neighbouring buffers never share a cache line */
+    static constexpr size_t block_alignment = 64;
+    /* room after the bytes for the shared_ptr control block */
+    static constexpr size_t control_room = 128;
+
+    class core
+    {
+    public:
+      explicit core(const config& cfg_)
+        : cfg(cfg_)
+      {
+        if (cfg.block_size == 0)
+        {
+          cfg.block_size = 1;
+        }
+        if (cfg.block_size > SIZE_MAX - block_alignment - control_room)
+        {
+          throw std::length_error("recycling_pool : block size too large");
+        }
+        control_offset = (cfg.block_size + block_alignment - 1) / block_alignment * block_alignment;
+
+        size_t prefill = std::min(cfg.prefill, cfg.max_pooled_bytes / cfg.block_size);
+        free_list.reserve(prefill);
+        for (size_t i = 0; i < prefill; i++)
+        {
+          free_list.push_back(allocateBlock());
+        }
+      }
+
+      ~core()
+      {
+        for (uint8_t* block : free_list)
+        {
+          freeBlock(block);
+        }
+      }
+
+      uint8_t* allocate()
+      {
+        {
+          std::lock_guard<std::mutex> lock(m);
+          counters.allocations++;
+          if (not free_list.empty())
+          {
+            counters.hits++;
+            uint8_t* block = free_list.back();
+            free_list.pop_back();
+            return block;
+          }
+          counters.misses++;
+        }
+
+        return allocateBlock();
+      }
+
+      void recycle(uint8_t* block)
+      {
+        {
+          std::lock_guard<std::mutex> lock(m);
+          if ((free_list.size() + 1) * cfg.block_size <= cfg.max_pooled_bytes)
+          {
+            counters.recycled++;
+            free_list.push_back(block);
+            return;
+          }
+          counters.discarded++;
+        }
+
+        freeBlock(block);
+      }
+
+      void trim()
+      {
+        std::vector<uint8_t*> blocks;
+        {
+          std::lock_guard<std::mutex> lock(m);
+          blocks.swap(free_list);
+        }
+        for (uint8_t* block : blocks)
+        {
+          freeBlock(block);
+        }
+      }
+
+      stats getStats()
+      {
+        std::lock_guard<std::mutex> lock(m);
+        stats res = counters;
+        res.pooled_bytes = free_list.size() * cfg.block_size;
+        return res;
+      }
+
+      size_t blockSize() const
+      {
+        return cfg.block_size;
+      }
+
+      /**
+        @brief  Places a control block in the room after a block's bytes, if it fits
+        */
+      void* allocateControl(uint8_t* block, size_t n, size_t align)
+      {
+        if (n <= control_room and align <= block_alignment)
+        {
+          return block + control_offset;
+        }
+        return ::operator new(n);
+      }
+
+      /**
+        @brief  Frees a control block, and with it the block it lives in
+        */
+      void releaseControl(uint8_t* block, void* control)
+      {
+        if (control != block + control_offset)
+        {
+          ::operator delete(control);
+        }
+        recycle(block);
+      }
+
+    protected:
+      uint8_t* allocateBlock()
+      {
+        return (uint8_t*)::operator new(control_offset + control_room,
+          std::align_val_t(block_alignment));
+      }
+
+      void freeBlock(uint8_t* block)
+      {
+        ::operator delete(block, std::align_val_t(block_alignment));
+      }
+
+      config cfg;
+      /* offset of the control block room in each block */
+      size_t control_offset;
+      std::mutex m;
+      /* used as a stack: push and pop at the back */
+      std::vector<uint8_t*> free_list;
+      stats counters;
+    };
+
+  public:
+    /**
+      @brief  Deleter marking a buffer as the pool's
+              Does nothing itself: the block returns to the pool when the control block
+              living in it is freed, which is after the deleter runs
+      */
+    struct recycler
+    {
+      core* owner;
+
+      void operator()(uint8_t*) const
+      {
+
+      }
+    };
+
+    /**
+      @brief  Allocator placing a buffer's control block inside its block
+      */
+    template<typename T>
+    class control_allocator
+    {
+    public:
+      using value_type = T;
+
+      control_allocator(core* owner_, uint8_t* block_)
+        : owner(owner_),
+          block(block_)
+      {}
+
+      template<typename U>
+      control_allocator(const control_allocator<U>& other)
+        : owner(other.owner),
+          block(other.block)
+      {}
+
+      T* allocate(size_t n)
+      {
+        return static_cast<T*>(owner->allocateControl(block, n * sizeof(T), alignof(T)));
+      }
+
+      void deallocate(T* p, size_t)
+      {
+        owner->releaseControl(block, p);
+      }
+
+      template<typename U>
+      bool operator==(const control_allocator<U>& other) const
+      {
+        return block == other.block;
+      }
+
+      template<typename U>
+      bool operator!=(const control_allocator<U>& other) const
+      {
+        return block != other.block;
+      }
+
+    protected:
+      template<typename U>
+      friend class control_allocator;
+
+      core* owner;
+      uint8_t* block;
+    };
+
+    /**
+      @brief  Constructor, using the default configuration
+      */
+    recycling_pool()
+      : c(std::make_unique<core>(config()))
+    {
+
+    }
+
+    /**
+      @brief  Constructor
+      @param  cfg
+              Block size, free list cap and prefill
+      */
+    explicit recycling_pool(const config& cfg)
+      : c(std::make_unique<core>(cfg))
+    {
+
+    }
+
+    recycling_pool(const recycling_pool&) = delete;
+    recycling_pool& operator=(const recycling_pool&) = delete;
+
+    /**
+      @brief  Creates a shared buffer of a whole block
+              When the last reference is dropped, the block returns to the pool
+      @note   Bytes are left uninitialized, and may hold a previous buffer's contents
+      */
+    shared_buf make()
+    {
+      return make(c->blockSize());
+    }
+
+    /**
+      @brief  Creates a shared buffer of the first sz bytes of a block
+      @param  sz
+              Number of bytes in buffer
+      @throw  std::length_error
+              If sz is larger than the block size
+      */
+    shared_buf make(size_t sz)
+    {
+      if (sz > c->blockSize())
+      {
+        throw std::length_error("recycling_pool::make() : size exceeds block size");
+      }
+      uint8_t* block = c->allocate();
+      try
+      {
+        return shared_buf(sz, std::shared_ptr<uint8_t[]>(block, recycler{c.get()},
+          control_allocator<uint8_t>(c.get(), block)));
+      }
+      catch (...)
+      {
+        /* the control block did not fit and could not be allocated elsewhere either */
+        c->recycle(block);
+        throw;
+      }
+    }
+
+    /**
+      @brief  Returns true if the buffer (or the buffer it was sliced from) came from this pool
+      */
+    bool owns(const shared_buf& buf) const
+    {
+      const recycler* r = buf.getDeleter<recycler>();
+      return r != nullptr and r->owner == c.get();
+    }
+
+    /**
+      @brief  Frees the blocks on the free list
+      */
+    void trim()
+    {
+      c->trim();
+    }
+
+    /**
+      @brief  Returns counters
+      */
+    stats getStats() const
+    {
+      return c->getStats();
+    }
+
+    /**
+      @brief  Returns the size of every block
+      */
+    size_t blockSize() const
+    {
+      return c->blockSize();
+    }
+
+  protected:
+    std::unique_ptr<core> c;
+  };
+}
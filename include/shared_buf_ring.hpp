@@ -0,0 +1,389 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2020 Kevin Xu
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#pragma once
+
+#if __cplusplus < 202002L
+#error "shared_buf_ring.hpp requires C++20"
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "shared_buf.hpp"
+#include "shared_buf_mmap.hpp"
+#include "shared_buf_shm.hpp"
+
+namespace xu
+{
+  namespace detail
+  {
+    /**
+      @brief  Maps the same len bytes of a memfd twice, back to back, so that any window of
+              up to len bytes starting in the first copy is contiguous
+      */
+    inline shared_buf mapMirror(size_t len)
+    {
+      int fd = createShm("shared_buf_ring");
+      if (fd < 0)
+      {
+        throwErrno("xu::spsc_ring : memfd_create");
+      }
+      if (::ftruncate(fd, (off_t)len) != 0)
+      {
+        int err = errno;
+        ::close(fd);
+        throw std::system_error(err, std::generic_category(), "xu::spsc_ring : ftruncate");
+      }
+
+      /* reserve both halves first, so that nothing else can be mapped between them */
+      void* base = ::mmap(nullptr, 2 * len, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (base == MAP_FAILED)
+      {
+        int err = errno;
+        ::close(fd);
+        throw std::system_error(err, std::generic_category(), "xu::spsc_ring : mmap");
+      }
+
+      for (size_t half = 0; half < 2; half++)
+      {
+        void* at = (uint8_t*)base + half * len;
+        if (::mmap(at, len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED)
+        {
+          int err = errno;
+          ::munmap(base, 2 * len);
+          ::close(fd);
+          throw std::system_error(err, std::generic_category(), "xu::spsc_ring : mmap");
+        }
+      }
+      /* the mappings keep the pages alive */
+      ::close(fd);
+
+      return shared_buf(2 * len, std::shared_ptr<uint8_t[]>((uint8_t*)base,
+        munmap_deleter{base, 2 * len}));
+    }
+  }
+
+  /**
+    @brief  Wait-free single-producer, single-consumer byte ring in one shared_buf
+            The producer stages bytes with write() or prepare() and publishes them in a
+            batch with commit(); the consumer takes zero-copy slices with read() and hands
+            the space back in a batch with release()
+    @note   Exactly one thread may call the producer functions, and one the consumer
+            functions. Slices returned by read() keep the storage alive, but their bytes
+            may be overwritten once released
+    @note   Unless mirrored, a prepare() that does not fit before the end of the ring pads
+            the rest of it and starts over at the beginning; the consumer skips the padding,
+            and stops each read at it
+    */
+  class spsc_ring
+  {
+  public:
+    static constexpr size_t cache_line = 64;
+
+    //  ================
+    //  Member Functions
+    //  ================
+
+    /**
+      @brief  Constructor
+      @param  capacity
+              Number of bytes in the ring, rounded up to a power of two (and, when mirrored,
+              to at least a page)
+      @param  mirror
+              Map the storage twice back to back, so that every read() and prepare() is
+              contiguous, even across the end of the ring
+      @throw  std::system_error
+              If the mirrored mapping cannot be created
+      */
+    explicit spsc_ring(size_t capacity, bool mirror = false)
+      : cap(std::bit_ceil(std::max(capacity, mirror ? detail::pageSize() : size_t(1)))),
+        mirrored(mirror),
+        storage(mirror ? detail::mapMirror(cap) : make_shared_buf(cap))
+    {
+
+    }
+
+    spsc_ring(const spsc_ring&) = delete;
+    spsc_ring& operator=(const spsc_ring&) = delete;
+
+    /*
+     *  Producer
+     */
+
+    /**
+      @brief  Returns the number of bytes that can be staged
+      */
+    size_t writable()
+    {
+      return space(cap);
+    }
+
+    /**
+      @brief  Stages n contiguous bytes for the caller to fill
+              Unless mirrored, bytes that would wrap around the end of the ring are staged
+              at its beginning instead, and the space up to the end is skipped
+      @return Pointer to the bytes, or nullptr if there is not enough space, counting any
+              space skipped; commit() anything staged and try again later
+      */
+    uint8_t* prepare(size_t n)
+    {
+      size_t offset = (size_t)(prod.staged & (cap - 1));
+      if (mirrored or n <= cap - offset)
+      {
+        if (n > space(n))
+        {
+          return nullptr;
+        }
+
+        prod.staged += n;
+        return storage.data() + offset;
+      }
+
+      size_t skipped = cap - offset;
+      if (n > cap)
+      {
+        return nullptr;
+      }
+
+      if (skipped + n <= space(skipped + n))
+      {
+        /* published with the next commit(), whose release store orders it */
+        prod.pad.store(prod.staged, std::memory_order_relaxed);
+        prod.staged += skipped + n;
+        return storage.data();
+      }
+
+      /*
+       *  No room for both: pad now, so that the bytes can be staged at the beginning once
+       *  the consumer frees it. The padding is published at once if nothing else is staged,
+       *  since the producer may not commit again until prepare() succeeds
+       */
+      if (skipped <= space(skipped) and prod.staged == prod.head.load(std::memory_order_relaxed))
+      {
+        prod.pad.store(prod.staged, std::memory_order_relaxed);
+        prod.staged += skipped;
+        prod.head.store(prod.staged, std::memory_order_release);
+      }
+      return nullptr;
+    }
+
+    /**
+      @brief  Copies as many of n bytes as there is space for, wrapping around the end
+      @return Number of bytes staged
+      */
+    size_t write(const void* bytes, size_t n)
+    {
+      n = std::min(n, space(n));
+      size_t offset = (size_t)(prod.staged & (cap - 1));
+      size_t first = mirrored ? n : std::min(n, cap - offset);
+
+      std::memcpy(storage.data() + offset, bytes, first);
+      std::memcpy(storage.data(), (const uint8_t*)bytes + first, n - first);
+
+      prod.staged += n;
+      return n;
+    }
+
+    /**
+      @brief  Publishes every staged byte to the consumer
+      */
+    void commit()
+    {
+      prod.head.store(prod.staged, std::memory_order_release);
+    }
+
+    /*
+     *  Consumer
+     */
+
+    /**
+      @brief  Returns the number of committed bytes not yet read, up to any padding
+      */
+    size_t readable()
+    {
+      return available(cap);
+    }
+
+    /**
+      @brief  Reads up to max committed bytes as a zero-copy slice of the storage
+              Unless mirrored, stops at the end of the ring; read again for the rest
+      @return Slice, empty if nothing is readable
+      */
+    shared_buf read(size_t max = SIZE_MAX)
+    {
+      size_t n = std::min(available(max), max);
+      size_t offset = (size_t)(cons.taken & (cap - 1));
+      if (not mirrored)
+      {
+        n = std::min(n, cap - offset);
+      }
+
+      cons.taken += n;
+      return storage.slice(offset, n);
+    }
+
+    /**
+      @brief  Copies up to n committed bytes out, wrapping around the end and skipping
+              any padding
+      @return Number of bytes read
+      */
+    size_t read(void* out, size_t n)
+    {
+      size_t done = 0;
+      while (done < n)
+      {
+        size_t chunk = std::min(n - done, available(n - done));
+        if (chunk == 0)
+        {
+          break;
+        }
+
+        size_t offset = (size_t)(cons.taken & (cap - 1));
+        size_t first = mirrored ? chunk : std::min(chunk, cap - offset);
+
+        std::memcpy((uint8_t*)out + done, storage.data() + offset, first);
+        std::memcpy((uint8_t*)out + done + first, storage.data(), chunk - first);
+
+        cons.taken += chunk;
+        done += chunk;
+      }
+      return done;
+    }
+
+    /**
+      @brief  Hands the space of every byte read so far back to the producer
+      */
+    void release()
+    {
+      cons.tail.store(cons.taken, std::memory_order_release);
+    }
+
+    /**
+      @brief  Returns capacity in bytes
+      */
+    size_t capacity() const
+    {
+      return cap;
+    }
+
+    /**
+      @brief  Returns whether the storage is mapped twice back to back
+      */
+    bool isMirrored() const
+    {
+      return mirrored;
+    }
+
+  protected:
+    /**
+      @brief  Returns the space for staging, reloading the consumer's position only if the
+              cached one leaves less than wanted
+      */
+    size_t space(size_t wanted)
+    {
+      size_t free = cap - (size_t)(prod.staged - prod.tail_cache);
+      if (free < wanted)
+      {
+        prod.tail_cache = cons.tail.load(std::memory_order_acquire);
+        free = cap - (size_t)(prod.staged - prod.tail_cache);
+      }
+      return free;
+    }
+
+    /**
+      @brief  Returns the committed bytes not yet read, reloading the producer's position
+              only if the cached one leaves fewer than wanted
+              Skips padding that starts at the read position, and stops at padding ahead
+      */
+    size_t available(size_t wanted)
+    {
+      size_t avail = (size_t)(cons.head_cache - cons.taken);
+      if (avail < wanted)
+      {
+        cons.head_cache = prod.head.load(std::memory_order_acquire);
+        cons.pad_cache = prod.pad.load(std::memory_order_relaxed);
+        avail = (size_t)(cons.head_cache - cons.taken);
+      }
+
+      /* padding counts only once committed; it always ends at the end of the ring */
+      if (cons.pad_cache >= cons.taken and cons.pad_cache < cons.head_cache)
+      {
+        if (cons.pad_cache == cons.taken)
+        {
+          cons.taken += cap - (size_t)(cons.taken & (cap - 1));
+          avail = (size_t)(cons.head_cache - cons.taken);
+        }
+        else
+        {
+          avail = (size_t)(cons.pad_cache - cons.taken);
+        }
+      }
+      return avail;
+    }
+
+    /*
+     *  Positions count bytes since construction and are masked into the storage; each side
+     *  keeps a cached copy of the other's position on its own cache line, so that it only
+     *  touches the other's line when the cache says the ring is full (or empty)
+     */
+
+    struct alignas(cache_line) producer
+    {
+      std::atomic<uint64_t> head{0};
+      /* position of the latest padding, which runs to the end of the ring */
+      std::atomic<uint64_t> pad{UINT64_MAX};
+      uint64_t staged = 0;
+      uint64_t tail_cache = 0;
+    };
+
+    struct alignas(cache_line) consumer
+    {
+      std::atomic<uint64_t> tail{0};
+      uint64_t taken = 0;
+      uint64_t head_cache = 0;
+      uint64_t pad_cache = UINT64_MAX;
+    };
+
+    //  ================
+    //  Member Variables
+    //  ================
+
+    size_t cap;
+    bool mirrored;
+    shared_buf storage;
+    producer prod;
+    consumer cons;
+  };
+}
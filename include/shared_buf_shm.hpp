@@ -0,0 +1,394 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2020 Kevin Xu
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "shared_buf.hpp"
+
+namespace xu
+{
+  /**
+    @brief  Describes where the bytes of a shared-memory buffer live
+    @note   fd remains owned by the buffer it was exported from
+    */
+  struct shm_handle
+  {
+    int fd;
+    /* offset of the first byte within the shared-memory object */
+    size_t offset;
+    size_t size;
+  };
+
+  namespace detail
+  {
+    inline void shm_deleter::operator()(uint8_t*) const
+    {
+      ::munmap(base, len);
+      ::close(fd);
+    }
+
+    inline void throwErrno(const char* what)
+    {
+      throw std::system_error(errno, std::generic_category(), what);
+    }
+
+    inline size_t shmPageSize()
+    {
+      static const size_t page = (size_t)::sysconf(_SC_PAGESIZE);
+      return page;
+    }
+
+    /**
+      @brief  Creates an anonymous shared-memory object that allows sealing
+      */
+    inline int createShm(const std::string& name)
+    {
+#if defined(MFD_CLOEXEC) and defined(MFD_ALLOW_SEALING)
+      int fd = ::memfd_create(name.c_str(), MFD_CLOEXEC | MFD_ALLOW_SEALING);
+      if (fd >= 0 or errno != ENOSYS)
+      {
+        return fd;
+      }
+#endif
+      /* fall back to POSIX shared memory, unlinked immediately; such objects cannot be sealed */
+      static std::atomic<unsigned> counter{0};
+      std::string shm_name = "/" + name + "." + std::to_string(::getpid()) + "."
+        + std::to_string(counter++);
+      int fd2 = ::shm_open(shm_name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+      if (fd2 >= 0)
+      {
+        ::shm_unlink(shm_name.c_str());
+      }
+      return fd2;
+    }
+
+    /**
+      @brief  Maps [offset, offset + sz) of a shared-memory object and wraps it in a buffer
+              that takes ownership of fd
+      */
+    inline shared_buf mapShm(int fd, size_t offset, size_t sz, bool writable)
+    {
+      size_t map_offset = offset - offset % shmPageSize();
+      size_t lead = offset - map_offset;
+      size_t map_len = lead + (sz == 0 ? 1 : sz);
+
+      int prot = PROT_READ | (writable ? PROT_WRITE : 0);
+      void* base = ::mmap(nullptr, map_len, prot, MAP_SHARED, fd, (off_t)map_offset);
+      if (base == MAP_FAILED)
+      {
+        int err = errno;
+        ::close(fd);
+        throw std::system_error(err, std::generic_category(), "xu::shm : mmap");
+      }
+
+      uint8_t* data = (uint8_t*)base + lead;
+      return shared_buf(sz, std::shared_ptr<uint8_t[]>(data,
+        shm_deleter{base, map_len, fd, map_offset}));
+    }
+  }
+
+  /**
+    @brief  Creates a shared buffer backed by an anonymous shared-memory object (memfd_create,
+            or shm_open where memfd is unavailable), which can be exported to other processes
+    @param  sz
+            Number of bytes in buffer
+    @param  name
+            Name of the object, for debugging only
+    @note   Bytes are zero-initialized
+    @throw  std::system_error
+            If the object cannot be created or mapped
+    */
+  inline shared_buf make_shm_buf(size_t sz, const std::string& name = "shared_buf")
+  {
+    int fd = detail::createShm(name);
+    if (fd < 0)
+    {
+      detail::throwErrno("xu::make_shm_buf : memfd_create");
+    }
+
+    if (::ftruncate(fd, (off_t)sz) != 0)
+    {
+      int err = errno;
+      ::close(fd);
+      throw std::system_error(err, std::generic_category(), "xu::make_shm_buf : ftruncate");
+    }
+
+    return detail::mapShm(fd, 0, sz, true);
+  }
+
+  /**
+    @brief  Returns true if the buffer (or the buffer it was sliced from) is backed by
+            shared memory
+    */
+  inline bool is_shm_buf(const shared_buf& buf)
+  {
+    return buf.getDeleter<detail::shm_deleter>() != nullptr;
+  }
+
+  /**
+    @brief  Describes a shared-memory buffer so that another process can map it
+    @throw  std::invalid_argument
+            If the buffer is not backed by shared memory
+    */
+  inline shm_handle export_shm(const shared_buf& buf)
+  {
+    const detail::shm_deleter* del = buf.getDeleter<detail::shm_deleter>();
+    if (del == nullptr)
+    {
+      throw std::invalid_argument("xu::export_shm : buffer is not backed by shared memory");
+    }
+
+    size_t offset = del->file_offset + (size_t)(buf.data() - (const uint8_t*)del->base);
+    return shm_handle{del->fd, offset, buf.size()};
+  }
+
+  /**
+    @brief  Maps a region of a shared-memory object as a shared buffer
+    @param  fd
+            Descriptor of the object; ownership passes to the returned buffer
+    @param  writable
+            Sealed objects can only be imported read-only
+    @throw  std::system_error
+            If the region cannot be mapped
+    */
+  inline shared_buf import_shm(int fd, size_t offset, size_t sz, bool writable = false)
+  {
+    return detail::mapShm(fd, offset, sz, writable);
+  }
+
+  /**
+    @brief  Returns true if the object behind fd can no longer be written, resized or resealed
+    */
+  inline bool is_sealed_shm(int fd)
+  {
+#ifdef F_GET_SEALS
+    int seals = ::fcntl(fd, F_GET_SEALS);
+    int required = F_SEAL_WRITE | F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL;
+    return seals >= 0 and (seals & required) == required;
+#else
+    (void)fd;
+    return false;
+#endif
+  }
+
+  /**
+    @brief  Makes a shared-memory buffer immutable, so that receivers can trust its contents
+            The mapping is replaced in place by a read-only one (writes through any copy of
+            the buffer fault afterwards), then write, resize and seal seals are applied
+    @note   Fails with EBUSY if this process holds any other writable mapping of the object;
+            the buffer is then left writable
+    @throw  std::invalid_argument
+            If the buffer is not backed by shared memory
+    @throw  std::system_error
+            If the object cannot be sealed
+    */
+  inline void seal_shm(const shared_buf& buf)
+  {
+    const detail::shm_deleter* del = buf.getDeleter<detail::shm_deleter>();
+    if (del == nullptr)
+    {
+      throw std::invalid_argument("xu::seal_shm : buffer is not backed by shared memory");
+    }
+
+#ifdef F_ADD_SEALS
+    /* a mapping made through a read-only description does not count as writable */
+    std::string self = "/proc/self/fd/" + std::to_string(del->fd);
+    int ro_fd = ::open(self.c_str(), O_RDONLY | O_CLOEXEC);
+    if (ro_fd < 0)
+    {
+      detail::throwErrno("xu::seal_shm : open");
+    }
+
+    void* res = ::mmap(del->base, del->len, PROT_READ, MAP_SHARED | MAP_FIXED, ro_fd,
+      (off_t)del->file_offset);
+    int err = errno;
+    ::close(ro_fd);
+    if (res == MAP_FAILED)
+    {
+      throw std::system_error(err, std::generic_category(), "xu::seal_shm : mmap");
+    }
+
+    /* sealing writes needs the read-only mapping first; if it fails, make it writable again */
+    if (::fcntl(del->fd, F_ADD_SEALS, F_SEAL_WRITE | F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) != 0)
+    {
+      err = errno;
+      ::mmap(del->base, del->len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, del->fd,
+        (off_t)del->file_offset);
+      throw std::system_error(err, std::generic_category(), "xu::seal_shm : F_ADD_SEALS");
+    }
+#else
+    throw std::system_error(ENOTSUP, std::generic_category(), "xu::seal_shm");
+#endif
+  }
+
+  /**
+    @brief  Sends a shared-memory buffer over a UNIX socket
+            The descriptor travels as SCM_RIGHTS ancillary data, alongside the offset and size
+    @throw  std::invalid_argument
+            If the buffer is not backed by shared memory
+    @throw  std::system_error
+            If sending fails
+    */
+  inline void send_shm(int sock, const shared_buf& buf)
+  {
+    shm_handle h = export_shm(buf);
+
+    uint64_t header[2] = {h.offset, h.size};
+    struct iovec iov = {header, sizeof(header)};
+
+    alignas(struct cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+    std::memset(control, 0, sizeof(control));
+
+    struct msghdr msg;
+    std::memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    std::memcpy(CMSG_DATA(cmsg), &h.fd, sizeof(int));
+
+    ssize_t res;
+    do
+    {
+      res = ::sendmsg(sock, &msg, MSG_NOSIGNAL);
+    } while (res < 0 and errno == EINTR);
+
+    if (res < 0)
+    {
+      detail::throwErrno("xu::send_shm : sendmsg");
+    }
+    if ((size_t)res != sizeof(header))
+    {
+      throw std::system_error(EMSGSIZE, std::generic_category(), "xu::send_shm : short send");
+    }
+  }
+
+  /**
+    @brief  Receives a shared-memory buffer sent with send_shm() and maps the same pages
+    @param  require_sealed
+            If true, the buffer is rejected unless the sender sealed it; it is then
+            mapped read-only
+    @throw  std::system_error
+            If receiving or mapping fails, or sealing is required but missing; with
+            std::errc::not_connected if the peer closed the socket
+    */
+  inline shared_buf recv_shm(int sock, bool require_sealed = false)
+  {
+    uint64_t header[2];
+    struct iovec iov = {header, sizeof(header)};
+
+    alignas(struct cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+
+    struct msghdr msg;
+    std::memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    ssize_t res;
+    do
+    {
+      res = ::recvmsg(sock, &msg, MSG_CMSG_CLOEXEC);
+    } while (res < 0 and errno == EINTR);
+
+    if (res < 0)
+    {
+      detail::throwErrno("xu::recv_shm : recvmsg");
+    }
+
+    /* keep the first descriptor, and close any others a peer sent along */
+    int fd = -1;
+    for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg))
+    {
+      if (cmsg->cmsg_level == SOL_SOCKET and cmsg->cmsg_type == SCM_RIGHTS)
+      {
+        size_t count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        for (size_t i = 0; i < count; i++)
+        {
+          int received;
+          std::memcpy(&received, CMSG_DATA(cmsg) + i * sizeof(int), sizeof(int));
+          if (fd < 0)
+          {
+            fd = received;
+          }
+          else
+          {
+            ::close(received);
+          }
+        }
+      }
+    }
+
+    if (res == 0 and fd < 0)
+    {
+      throw std::system_error(ENOTCONN, std::generic_category(), "xu::recv_shm : connection closed");
+    }
+
+    if ((size_t)res != sizeof(header) or fd < 0 or (msg.msg_flags & MSG_CTRUNC))
+    {
+      if (fd >= 0)
+      {
+        ::close(fd);
+      }
+      throw std::system_error(EBADMSG, std::generic_category(), "xu::recv_shm : malformed message");
+    }
+
+    bool sealed = is_sealed_shm(fd);
+    if (require_sealed and not sealed)
+    {
+      ::close(fd);
+      throw std::system_error(EPERM, std::generic_category(), "xu::recv_shm : buffer is not sealed");
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 or header[0] > (uint64_t)st.st_size
+      or header[1] > (uint64_t)st.st_size - header[0])
+    {
+      ::close(fd);
+      throw std::system_error(EBADMSG, std::generic_category(), "xu::recv_shm : range out of object");
+    }
+
+    return import_shm(fd, (size_t)header[0], (size_t)header[1], not sealed);
+  }
+}
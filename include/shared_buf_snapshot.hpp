@@ -0,0 +1,243 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2020 Kevin Xu
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "shared_buf.hpp"
+#include "shared_buf_shm.hpp"
+
+/*
+ *  Snapshot buffers live in a memfd. The buffer returned by make_snapshot_buf() starts out
+ *  as a MAP_SHARED mapping, so its writes go to the file. Its first deepCopy() maps the file
+ *  MAP_PRIVATE for the copy and remaps the original MAP_PRIVATE in place: from then on the
+ *  file never changes, and every mapping of it is copy-on-write, so the kernel only copies
+ *  pages that are written.
+ *
+ *  Later copies of a private mapping map the file MAP_PRIVATE again, then copy over just the
+ *  pages the source has written, which /proc/self/pagemap reports as anonymous rather than
+ *  file pages.
+ */
+
+namespace xu
+{
+  namespace detail
+  {
+    /**
+      @brief  The memfd shared by a snapshot buffer and all of its copies
+      */
+    struct snapshot_file
+    {
+      int fd;
+      std::mutex mutex;
+
+      explicit snapshot_file(int fd_)
+        : fd(fd_)
+      {
+
+      }
+
+      ~snapshot_file()
+      {
+        ::close(fd);
+      }
+    };
+
+    inline void snapshot_deleter::operator()(uint8_t*) const
+    {
+      ::munmap(base, len);
+    }
+
+    /**
+      @brief  Marks the pages in [begin, begin + len) that this process has written since
+              they were mapped MAP_PRIVATE, i.e. that are no longer file pages
+      @param  dirty
+              One entry per page, set to true for written pages
+      @return False if /proc/self/pagemap is unavailable
+      */
+    inline bool privatePages(const uint8_t* begin, size_t len, std::vector<bool>& dirty)
+    {
+      const uint64_t present = 1ull << 63;
+      const uint64_t swapped = 1ull << 62;
+      const uint64_t file_page = 1ull << 61;
+
+      int fd = ::open("/proc/self/pagemap", O_RDONLY | O_CLOEXEC);
+      if (fd < 0)
+      {
+        return false;
+      }
+
+      size_t page = shmPageSize();
+      size_t pages = len / page;
+      dirty.assign(pages, false);
+
+      uint64_t entries[512];
+      for (size_t first = 0; first < pages; )
+      {
+        size_t count = std::min(pages - first, sizeof(entries) / sizeof(entries[0]));
+        off_t at = (off_t)(((uintptr_t)begin / page + first) * sizeof(uint64_t));
+        ssize_t got = ::pread(fd, entries, count * sizeof(uint64_t), at);
+        if (got <= 0)
+        {
+          ::close(fd);
+          return false;
+        }
+
+        count = (size_t)got / sizeof(uint64_t);
+        for (size_t i = 0; i < count; i++)
+        {
+          uint64_t e = entries[i];
+          dirty[first + i] = (e & swapped) or ((e & present) and not (e & file_page));
+        }
+        first += count;
+      }
+
+      ::close(fd);
+      return true;
+    }
+
+    inline shared_buf snapshotCopy(const shared_buf& buf, snapshot_deleter& deleter)
+    {
+      size_t page = shmPageSize();
+      /* positions are in the file, since the source may itself be a copy mapped part-way in */
+      size_t offset = deleter.file_offset + (size_t)(buf.data() - deleter.base);
+      size_t map_offset = offset - offset % page;
+      size_t map_len = std::min(deleter.file_offset + deleter.len - map_offset,
+        (offset + buf.size() - map_offset + page - 1) / page * page);
+      if (map_len == 0)
+      {
+        map_len = page;
+      }
+
+      std::lock_guard<std::mutex> lock(deleter.file->mutex);
+
+      void* mapped = ::mmap(nullptr, map_len, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+        deleter.file->fd, (off_t)map_offset);
+      if (mapped == MAP_FAILED)
+      {
+        throwErrno("xu::shared_buf::deepCopy : mmap");
+      }
+      std::shared_ptr<uint8_t[]> owner((uint8_t*)mapped,
+        snapshot_deleter{(uint8_t*)mapped, map_len, map_offset, deleter.file, false,
+          &snapshotCopy});
+
+      if (deleter.writes_file)
+      {
+        /* freeze the file: the source becomes copy-on-write over it too, at the same address */
+        void* remapped = ::mmap(deleter.base, deleter.len, PROT_READ | PROT_WRITE,
+          MAP_PRIVATE | MAP_FIXED, deleter.file->fd, (off_t)deleter.file_offset);
+        if (remapped == MAP_FAILED)
+        {
+          throwErrno("xu::shared_buf::deepCopy : mmap");
+        }
+        deleter.writes_file = false;
+      }
+      else
+      {
+        /* an empty window at the end of the source maps a page the source does not have */
+        std::vector<bool> dirty;
+        uint8_t* src = deleter.base + (map_offset - deleter.file_offset);
+        size_t src_len = std::min(map_len, deleter.file_offset + deleter.len - map_offset);
+        if (privatePages(src, src_len, dirty))
+        {
+          for (size_t i = 0; i < dirty.size(); i++)
+          {
+            if (dirty[i])
+            {
+              std::memcpy((uint8_t*)mapped + i * page, src + i * page, page);
+            }
+          }
+        }
+        else
+        {
+          std::memcpy((uint8_t*)mapped + (offset - map_offset), buf.data(), buf.size());
+        }
+      }
+
+      return shared_buf(buf.size(), std::shared_ptr<uint8_t[]>(owner,
+        (uint8_t*)mapped + (offset - map_offset)));
+    }
+  }
+
+  /**
+    @brief  Creates a shared buffer backed by a memfd, whose deepCopy() maps the same pages
+            copy-on-write instead of copying them, so that snapshots of very large buffers
+            are cheap in time and only grow memory by the pages later written
+    @param  sz
+            Number of bytes in buffer
+    @param  name
+            Name of the memfd, for debugging only
+    @note   Bytes are zero-initialized. The buffer, its slices and its copies otherwise behave
+            as any other shared_buf
+    @throw  std::system_error
+            If the memfd cannot be created or mapped
+    */
+  inline shared_buf make_snapshot_buf(size_t sz, const std::string& name = "shared_buf")
+  {
+    int fd = detail::createShm(name);
+    if (fd < 0)
+    {
+      detail::throwErrno("xu::make_snapshot_buf : memfd_create");
+    }
+    auto file = std::make_shared<detail::snapshot_file>(fd);
+
+    size_t page = detail::shmPageSize();
+    size_t len = sz == 0 ? page : (sz + page - 1) / page * page;
+    if (::ftruncate(fd, (off_t)len) != 0)
+    {
+      detail::throwErrno("xu::make_snapshot_buf : ftruncate");
+    }
+
+    void* base = ::mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED)
+    {
+      detail::throwErrno("xu::make_snapshot_buf : mmap");
+    }
+
+    return shared_buf(sz, std::shared_ptr<uint8_t[]>((uint8_t*)base,
+      detail::snapshot_deleter{(uint8_t*)base, len, 0, file, true, &detail::snapshotCopy}));
+  }
+
+  /**
+    @brief  Returns true if the buffer (or the buffer it was sliced or copied from) was
+            created by make_snapshot_buf()
+    */
+  inline bool is_snapshot_buf(const shared_buf& buf)
+  {
+    return buf.getDeleter<detail::snapshot_deleter>() != nullptr;
+  }
+}
@@ -0,0 +1,287 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2020 Kevin Xu
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <ostream>
+#include <stdexcept>
+#include <string_view>
+
+#include "shared_buf.hpp"
+#include "unique_buf.hpp"
+
+namespace xu
+{
+  /**
+    @brief  Implements a non-owning, read-only view of bytes
+            A pointer and a size, trivially copyable; obtaining or passing one never
+            touches a reference count
+    @note   The viewed buffer must outlive the view
+    */
+  class shared_buf_view
+  {
+  public:
+    //  =========
+    //  Iterators
+    //  =========
+
+    using iterator = shared_buf::const_iterator;
+    using const_iterator = shared_buf::const_iterator;
+    using reverse_iterator = shared_buf::const_reverse_iterator;
+    using const_reverse_iterator = shared_buf::const_reverse_iterator;
+
+    const_iterator begin() const
+    {
+      return shared_buf::makeIterator(ptr, sz, 0);
+    }
+
+    const_iterator end() const
+    {
+      return shared_buf::makeIterator(ptr, sz, sz);
+    }
+
+    const_iterator cbegin() const
+    {
+      return begin();
+    }
+
+    const_iterator cend() const
+    {
+      return end();
+    }
+
+    const_reverse_iterator rbegin() const
+    {
+      return const_reverse_iterator(end());
+    }
+
+    const_reverse_iterator rend() const
+    {
+      return const_reverse_iterator(begin());
+    }
+
+    //  ================
+    //  Member Functions
+    //  ================
+
+    /**
+      @brief  Constructor, creates an empty view
+      */
+    shared_buf_view()
+      : ptr(nullptr),
+        sz(0)
+    {
+
+    }
+
+    /**
+      @brief  Constructor
+      @param  ptr_
+              First byte
+      @param  sz_
+              Number of bytes
+      */
+    shared_buf_view(const uint8_t* ptr_, size_t sz_)
+      : ptr(ptr_),
+        sz(sz_)
+    {
+
+    }
+
+    /**
+      @brief  Constructor, views a shared buffer (or a slice of one)
+      */
+    shared_buf_view(const shared_buf& buf)
+      : ptr(buf.data()),
+        sz(buf.size())
+    {
+
+    }
+
+    /**
+      @brief  Constructor, views a unique buffer
+      */
+    shared_buf_view(const unique_buf& buf)
+      : ptr(buf.data()),
+        sz(buf.size())
+    {
+
+    }
+
+    /**
+      @brief  Byte access
+      @param  i
+              Index
+      @throw  std::out_of_range
+              If index is not within size, unless XU_SHARED_BUF_CHECK selects a
+              policy without exceptions
+      */
+    const uint8_t& operator[](size_t i) const
+    {
+      detail::checkIndex(i, sz, "shared_buf_view::operator[] : index out of range");
+      return ptr[i];
+    }
+
+    /**
+      @brief  Byte access, checked under every policy
+      @throw  std::out_of_range
+              If index is not within size
+      */
+    const uint8_t& at(size_t i) const
+    {
+      if (i >= sz)
+      {
+        throw std::out_of_range("shared_buf_view::at() : index out of range");
+      }
+      return ptr[i];
+    }
+
+    /**
+      @brief  Pointer access
+      */
+    const uint8_t* data() const
+    {
+      return ptr;
+    }
+
+    /**
+      @brief  Returns a view of a window of this one
+      @throw  std::out_of_range
+              If the window does not lie within size
+      */
+    shared_buf_view subview(size_t offset, size_t length) const
+    {
+      if (offset > sz or length > sz - offset)
+      {
+        throw std::out_of_range("shared_buf_view::subview() : window out of range");
+      }
+      return shared_buf_view(ptr + offset, length);
+    }
+
+    /**
+      @brief  Output to string
+      @param  fmt
+              Hex layout, [01,02,...] by default
+      */
+    std::ostream& print(std::ostream& stream, const hex_format& fmt = hex_format()) const
+    {
+      return print_hex(stream, ptr, sz, fmt);
+    }
+
+    /**
+      @brief  Returns size
+      */
+    size_t size() const
+    {
+      return sz;
+    }
+
+    /**
+      @brief  Returns the bytes as a string_view, e.g. for hashing or searching
+      */
+    std::string_view bytes() const
+    {
+      return std::string_view((const char*)ptr, sz);
+    }
+
+  protected:
+    //  ================
+    //  Member Variables
+    //  ================
+
+    const uint8_t* ptr;
+    size_t sz;
+  };
+
+  /*
+   *  Comparisons are by content, lexicographic over unsigned bytes; since buffers convert
+   *  implicitly, they also compare shared_buf and unique_buf without touching refcounts
+   */
+
+  inline bool operator==(shared_buf_view lhs, shared_buf_view rhs)
+  {
+    return lhs.size() == rhs.size()
+      and (lhs.size() == 0 or std::memcmp(lhs.data(), rhs.data(), lhs.size()) == 0);
+  }
+
+  inline bool operator!=(shared_buf_view lhs, shared_buf_view rhs)
+  {
+    return not (lhs == rhs);
+  }
+
+  inline bool operator<(shared_buf_view lhs, shared_buf_view rhs)
+  {
+    return lhs.bytes() < rhs.bytes();
+  }
+
+  inline bool operator>(shared_buf_view lhs, shared_buf_view rhs)
+  {
+    return rhs < lhs;
+  }
+
+  inline bool operator<=(shared_buf_view lhs, shared_buf_view rhs)
+  {
+    return not (rhs < lhs);
+  }
+
+  inline bool operator>=(shared_buf_view lhs, shared_buf_view rhs)
+  {
+    return not (lhs < rhs);
+  }
+}
+
+inline std::ostream& operator<<(std::ostream& stream, xu::shared_buf_view view)
+{
+  return view.print(stream);
+}
+
+namespace std
+{
+  /**
+    @brief  Hashes by content
+    */
+  template<>
+  struct hash<xu::shared_buf_view>
+  {
+    size_t operator()(xu::shared_buf_view view) const
+    {
+      return hash<string_view>()(view.bytes());
+    }
+  };
+
+  /**
+    @brief  Hashes by content, consistently with shared_buf_view
+    */
+  template<>
+  struct hash<xu::shared_buf>
+  {
+    size_t operator()(const xu::shared_buf& buf) const
+    {
+      return hash<xu::shared_buf_view>()(buf);
+    }
+  };
+}
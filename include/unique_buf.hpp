@@ -0,0 +1,273 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2020 Kevin Xu
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "shared_buf.hpp"
+
+namespace xu
+{
+  /**
+    @brief  Implements a move-only buffer with a single owner
+            Has no control block and performs no atomic operations, which suits buffers
+            that are filled by one thread and only shared afterwards, via share()
+    */
+  class unique_buf
+  {
+  public:
+    //  =========
+    //  Iterators
+    //  =========
+
+    using iterator = shared_buf::iterator;
+    using const_iterator = shared_buf::const_iterator;
+    using reverse_iterator = shared_buf::reverse_iterator;
+    using const_reverse_iterator = shared_buf::const_reverse_iterator;
+
+    iterator begin()
+    {
+      checkLive();
+      return shared_buf::makeIterator(ptr.get(), sz, 0);
+    }
+
+    iterator end()
+    {
+      checkLive();
+      return shared_buf::makeIterator(ptr.get(), sz, sz);
+    }
+
+    const_iterator begin() const
+    {
+      checkLive();
+      return shared_buf::makeIterator((const uint8_t*)ptr.get(), sz, 0);
+    }
+
+    const_iterator end() const
+    {
+      checkLive();
+      return shared_buf::makeIterator((const uint8_t*)ptr.get(), sz, sz);
+    }
+
+    const_iterator cbegin() const
+    {
+      return begin();
+    }
+
+    const_iterator cend() const
+    {
+      return end();
+    }
+
+    reverse_iterator rbegin()
+    {
+      return reverse_iterator(end());
+    }
+
+    reverse_iterator rend()
+    {
+      return reverse_iterator(begin());
+    }
+
+    const_reverse_iterator rbegin() const
+    {
+      return const_reverse_iterator(end());
+    }
+
+    const_reverse_iterator rend() const
+    {
+      return const_reverse_iterator(begin());
+    }
+
+    //  ================
+    //  Member Functions
+    //  ================
+
+    /**
+      @brief  Constructor
+      @param  sz_
+              Number of bytes in buffer
+      @note   Bytes are left uninitialized, as with shared_buf(size_t)
+      */
+    explicit unique_buf(size_t sz_)
+      : sz(sz_),
+        ptr(new uint8_t[sz])
+    {
+
+    }
+
+    unique_buf(const unique_buf&) = delete;
+    unique_buf& operator=(const unique_buf&) = delete;
+
+    /**
+      @brief  Move constructor
+      */
+    unique_buf(unique_buf&& other) noexcept
+      : sz(other.sz),
+        ptr(std::move(other.ptr))
+    {
+      other.sz = 0;
+    }
+
+    /**
+      @brief  Move assignment
+      */
+    unique_buf& operator=(unique_buf&& other) noexcept
+    {
+      sz = other.sz;
+      ptr = std::move(other.ptr);
+
+      other.sz = 0;
+
+      return *this;
+    }
+
+    /**
+      @brief  Byte access
+      @param  i
+              Index
+      @throw  std::out_of_range
+              If index is not within size, unless XU_SHARED_BUF_CHECK selects a
+              policy without exceptions
+      */
+    uint8_t& operator[](size_t i)
+    {
+      checkLive();
+      detail::checkIndex(i, sz, "unique_buf::operator[] : index out of range");
+      return ptr[i];
+    }
+
+    /**
+      @brief  Byte access, const-qualified
+      @see    operator[](size_t)
+      */
+    const uint8_t& operator[](size_t i) const
+    {
+      checkLive();
+      detail::checkIndex(i, sz, "unique_buf::operator[] : index out of range");
+      return ptr[i];
+    }
+
+    /**
+      @brief  Byte access, checked under every policy
+      @throw  std::out_of_range
+              If index is not within size
+      */
+    uint8_t& at(size_t i)
+    {
+      if (i >= sz)
+      {
+        throw std::out_of_range("unique_buf::at() : index out of range");
+      }
+      return ptr[i];
+    }
+
+    /**
+      @brief  Byte access, checked under every policy, const-qualified
+      @throw  std::out_of_range
+              If index is not within size
+      */
+    const uint8_t& at(size_t i) const
+    {
+      if (i >= sz)
+      {
+        throw std::out_of_range("unique_buf::at() : index out of range");
+      }
+      return ptr[i];
+    }
+
+    /**
+      @brief  Pointer access
+      */
+    uint8_t* data()
+    {
+      checkLive();
+      return ptr.get();
+    }
+
+    /**
+      @brief  Pointer access, const-qualified
+      */
+    const uint8_t* data() const
+    {
+      checkLive();
+      return ptr.get();
+    }
+
+    /**
+      @brief  Converts into a shared buffer, without copying the bytes
+              This buffer is left empty, as if moved from
+      */
+    shared_buf share() &&
+    {
+      checkLive();
+      /* takes ptr only once the control block is allocated, so a throw leaves this intact */
+      std::shared_ptr<uint8_t[]> shared(std::move(ptr));
+      return shared_buf(std::exchange(sz, 0), std::move(shared));
+    }
+
+    /**
+      @brief  Output to string
+      @param  fmt
+              Hex layout, [01,02,...] by default
+      */
+    std::ostream& print(std::ostream& stream, const hex_format& fmt = hex_format()) const
+    {
+      checkLive();
+      return print_hex(stream, ptr.get(), sz, fmt);
+    }
+
+    /**
+      @brief  Returns size
+      */
+    size_t size() const
+    {
+      return sz;
+    }
+
+  protected:
+    void checkLive() const
+    {
+      detail::checkLive(ptr.get(), "unique_buf : use of moved-from buffer");
+    }
+
+    //  ================
+    //  Member Variables
+    //  ================
+
+    size_t sz;
+    std::unique_ptr<uint8_t[]> ptr;
+  };
+}
+
+inline std::ostream& operator<<(std::ostream& stream, const xu::unique_buf& buf)
+{
+  return buf.print(stream);
+}
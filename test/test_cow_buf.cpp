@@ -0,0 +1,102 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2020 Kevin Xu
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include <cstdio>
+#include <iostream>
+#include <numeric>
+#include <utility>
+
+#include "check.hpp"
+#include "cow_buf.hpp"
+#include "shared_buf_mmap.hpp"
+
+int main()
+{
+  xu::cow_buf buf(5);
+  std::iota(buf.begin(), buf.end(), 1);
+  const uint8_t* bytes = std::as_const(buf).data();
+
+  /*
+   *  Unlike shared_buf, writing through a copy leaves the original alone
+   */
+  xu::cow_buf buf_copy = buf;
+  CHECK(buf_copy.use_count() == 2);
+  CHECK(std::as_const(buf_copy).data() == bytes);
+  CHECK(std::as_const(buf_copy)[2] == 3);
+  CHECK(buf_copy.use_count() == 2);
+
+  buf_copy[2] = 0;
+  CHECK(std::as_const(buf_copy).data() != bytes);
+  CHECK(buf.use_count() == 1 and buf_copy.use_count() == 1);
+  std::cout << "buf=" << buf << " buf_copy=" << buf_copy << std::endl;
+  CHECK(std::as_const(buf)[2] == 3);
+
+  /*
+   *  The last owner writes in place
+   */
+  buf[0] = 0xaa;
+  CHECK(std::as_const(buf).data() == bytes);
+
+  /*
+   *  Adopted shared buffers and slices detach only while shared
+   */
+  xu::shared_buf shared = xu::make_shared_buf(4);
+  std::iota(shared.begin(), shared.end(), 10);
+  xu::cow_buf window(shared.slice(1, 2));
+  window.at(0) = 0;
+  CHECK(shared[1] == 11);
+  CHECK(window.size() == 2 and window[0] == 0 and window[1] == 12);
+  std::cout << "shared=" << shared << " window=" << window << std::endl;
+
+  /*
+   *  A read-only mapping is copied on the first write even when unshared
+   */
+  char path[] = "/tmp/test_cow_buf_XXXXXX";
+  int fd = ::mkstemp(path);
+  CHECK(fd >= 0);
+  ssize_t written = ::write(fd, "mapped", 6);
+  CHECK(written == 6);
+  ::close(fd);
+
+  xu::cow_buf mapped(xu::map_file(path));
+  std::remove(path);
+  const uint8_t* file_bytes = std::as_const(mapped).data();
+  CHECK(mapped.use_count() == 1);
+  mapped[0] = 'M';
+  CHECK(std::as_const(mapped).data() != file_bytes);
+  CHECK(mapped[0] == 'M' and mapped[5] == 'd');
+  std::cout << "mapped=" << mapped << std::endl;
+
+  xu::shared_buf_view view = buf_copy;
+  CHECK(view == buf_copy and view != buf);
+
+  try
+  {
+    buf.at(5);
+  }
+  catch (const std::out_of_range& e)
+  {
+    std::cout << "caught: " << e.what() << std::endl;
+  }
+}
@@ -22,9 +22,23 @@
  *  SOFTWARE.
  */
 
+#include <algorithm>
 #include <iostream>
+#include <numeric>
+#include "check.hpp"
 #include "shared_buf.hpp"
 
+#if not XU_SHARED_BUF_CHECKED_ITERATORS
+static_assert(sizeof(xu::shared_buf::iterator) == sizeof(void*));
+#if __cplusplus >= 202002L
+static_assert(std::contiguous_iterator<xu::shared_buf::iterator>);
+static_assert(std::contiguous_iterator<xu::shared_buf::const_iterator>);
+#endif
+#elif __cplusplus >= 202002L
+static_assert(std::bidirectional_iterator<xu::shared_buf::iterator>);
+static_assert(std::bidirectional_iterator<xu::shared_buf::const_iterator>);
+#endif
+
 void outputLoop(const xu::shared_buf& buf)
 {
   std::cout << "Test:";
@@ -62,9 +76,21 @@ int main()
   buf_copy[2] = 0;
 
   xu::shared_buf buf_moved = std::move(buf_copy);
+  CHECK(buf.use_count() == 2 and buf_copy.use_count() == 0);
 
   std::cout << "buf=" << buf << std::endl;
+#if XU_SHARED_BUF_CHECK == XU_SHARED_BUF_CHECK_HARDENED
+  try
+  {
+    std::cout << "buf=" << buf_copy << std::endl;
+  }
+  catch (const std::logic_error& e)
+  {
+    std::cout << "caught: " << e.what() << std::endl;
+  }
+#else
   std::cout << "buf=" << buf_copy << std::endl;
+#endif
   std::cout << "buf=" << buf_moved << std::endl;
 
   xu::shared_buf::const_iterator cit = buf.begin();
@@ -77,4 +103,73 @@ int main()
   }
 
   outputLoop(buf);
+
+  xu::shared_buf made = xu::make_shared_buf(4);
+  made[0] = 0xde;
+  made[1] = 0xad;
+  made[2] = 0xbe;
+  made[3] = 0xef;
+
+  std::cout << "made=" << made << std::endl;
+  std::cout << "made alignment=" << made.alignment() << std::endl;
+
+  xu::shared_buf header = made.slice(0, 2);
+  xu::shared_buf payload = made.slice(2);
+
+  made = xu::shared_buf(0);
+
+  payload[0] = 0;
+
+  std::cout << "header=" << header << std::endl;
+  std::cout << "payload=" << payload << std::endl;
+  outputLoop(payload.slice(1, 1));
+
+  std::cout << "reversed=";
+  for (auto rit = header.rbegin(); rit != header.rend(); rit++)
+  {
+    std::cout << (int)*rit << ' ';
+  }
+  std::cout << std::endl;
+
+  xu::shared_buf seq(16);
+  std::iota(seq.begin(), seq.end(), 0);
+  std::transform(seq.begin(), seq.end(), seq.begin(), [](uint8_t b) { return b * 2; });
+  std::cout << "transformed=" << seq << std::endl;
+  std::cout << "find 10 at " << std::distance(seq.cbegin(), std::find(seq.cbegin(), seq.cend(), 10))
+    << ", sum=" << std::accumulate(seq.begin(), seq.end(), 0) << std::endl;
+
+  xu::shared_buf small_zeroed = xu::shared_buf::zeroed(8);
+  xu::shared_buf large_zeroed = xu::shared_buf::zeroed(xu::shared_buf::zeroed_map_threshold + 3);
+  CHECK(std::all_of(small_zeroed.begin(), small_zeroed.end(), [](uint8_t b) { return b == 0; }));
+  CHECK(std::all_of(large_zeroed.begin(), large_zeroed.end(), [](uint8_t b) { return b == 0; }));
+  large_zeroed[large_zeroed.size() - 1] = 1;
+  CHECK(xu::shared_buf::uninitialized(3).size() == 3);
+  std::cout << "zeroed=" << small_zeroed << std::endl;
+
+  try
+  {
+    xu::make_shared_buf(SIZE_MAX - 8);
+  }
+  catch (const std::bad_alloc&)
+  {
+    std::cout << "caught: bad_alloc" << std::endl;
+  }
+
+  try
+  {
+    header.at(2);
+  }
+  catch (const std::out_of_range& e)
+  {
+    std::cout << "caught: " << e.what() << std::endl;
+  }
+
+  try
+  {
+    header.slice(1, 2);
+  }
+  catch (const std::out_of_range& e)
+  {
+    std::cout << "caught: " << e.what() << std::endl;
+  }
 }
\ No newline at end of file
@@ -0,0 +1,111 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2020 Kevin Xu
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include <cstdint>
+#include <iostream>
+#include <new>
+
+#include "check.hpp"
+#include "shared_buf_aligned.hpp"
+
+int main()
+{
+  const size_t alignments[] = {16, 64, 4096, size_t(2) << 20};
+
+  for (size_t a : alignments)
+  {
+    xu::alloc_options opts;
+    opts.alignment = a;
+
+    xu::shared_buf buf = xu::make_shared_buf(1000, opts);
+    CHECK(buf.size() == 1000);
+    CHECK(buf.alignment() >= a);
+
+    for (auto& b : buf)
+    {
+      b = 0x5a;
+    }
+
+    std::cout << "requested=" << a << " achieved=" << buf.alignment() << std::endl;
+  }
+
+  {
+    xu::alloc_options opts;
+    opts.huge = xu::huge_pages::transparent;
+
+    xu::shared_buf buf = xu::make_shared_buf(size_t(4) << 20, opts);
+    CHECK(buf.alignment() >= opts.huge_page_size);
+    buf[buf.size() - 1] = 1;
+    std::cout << "transparent achieved=" << buf.alignment() << std::endl;
+  }
+
+  {
+    /* succeeds whether or not huge pages are reserved on this system */
+    xu::alloc_options opts;
+    opts.huge = xu::huge_pages::hugetlb;
+
+    xu::shared_buf buf = xu::make_shared_buf(size_t(3) << 20, opts);
+    CHECK(buf.size() == size_t(3) << 20);
+    CHECK(buf.alignment() >= opts.huge_page_size);
+    buf[0] = 1;
+    std::cout << "hugetlb achieved=" << buf.alignment() << std::endl;
+  }
+
+  try
+  {
+    xu::alloc_options opts;
+    opts.alignment = 48;
+    xu::make_shared_buf(1, opts);
+  }
+  catch (const std::invalid_argument& e)
+  {
+    std::cout << "caught: " << e.what() << std::endl;
+  }
+
+  /*
+   *  Sizes whose padding for alignment would wrap around are rejected, not under-allocated
+   */
+  const xu::huge_pages policies[] = {xu::huge_pages::none, xu::huge_pages::transparent,
+    xu::huge_pages::hugetlb};
+  for (size_t a : alignments)
+  {
+    for (xu::huge_pages huge : policies)
+    {
+      xu::alloc_options opts;
+      opts.alignment = a;
+      opts.huge = huge;
+      bool thrown = false;
+      try
+      {
+        xu::make_shared_buf(SIZE_MAX - 8, opts);
+      }
+      catch (const std::bad_alloc&)
+      {
+        thrown = true;
+      }
+      CHECK(thrown);
+    }
+  }
+  std::cout << "caught: bad_alloc for wrapping sizes" << std::endl;
+}
@@ -0,0 +1,123 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2020 Kevin Xu
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include <iostream>
+#include <string>
+
+#include "check.hpp"
+#include "shared_buf.hpp"
+
+int main()
+{
+  /* RFC 4648 test vectors */
+  const char* vectors[][2] = {
+    {"", ""},
+    {"f", "Zg=="},
+    {"fo", "Zm8="},
+    {"foo", "Zm9v"},
+    {"foob", "Zm9vYg=="},
+    {"fooba", "Zm9vYmE="},
+    {"foobar", "Zm9vYmFy"},
+  };
+
+  for (auto& v : vectors)
+  {
+    std::string plain = v[0];
+    xu::shared_buf buf = xu::make_shared_buf(plain.size());
+    std::copy(plain.begin(), plain.end(), buf.begin());
+
+    CHECK(buf.toBase64() == v[1]);
+
+    xu::shared_buf decoded = xu::shared_buf::fromBase64(v[1]);
+    CHECK(decoded.size() == plain.size());
+    CHECK(std::string(decoded.data(), decoded.data() + decoded.size()) == plain);
+  }
+
+  /* round trips across the vectorized and scalar paths */
+  for (size_t sz = 0; sz < 200; sz++)
+  {
+    xu::shared_buf buf(sz);
+    for (size_t i = 0; i < sz; i++)
+    {
+      buf[i] = (uint8_t)(i * 97 + sz);
+    }
+
+    xu::shared_buf decoded = xu::shared_buf::fromBase64(buf.toBase64());
+    CHECK(decoded.size() == sz);
+    for (size_t i = 0; i < sz; i++)
+    {
+      CHECK(decoded[i] == buf[i]);
+    }
+  }
+
+  /* every byte value in every position of a long input, so each vector lane is checked */
+  xu::shared_buf plain(48);
+  for (size_t i = 0; i < plain.size(); i++)
+  {
+    plain[i] = (uint8_t)(i * 5);
+  }
+  std::string encoded = plain.toBase64();
+  for (size_t pos = 0; pos < encoded.size(); pos++)
+  {
+    for (int c = 0; c < 256; c++)
+    {
+      if (c == '=' and pos + 2 >= encoded.size())
+      {
+        /* padding in the final quantum is checked below */
+        continue;
+      }
+
+      std::string bad = encoded;
+      bad[pos] = (char)c;
+      bool valid = (c >= 'A' and c <= 'Z') or (c >= 'a' and c <= 'z') or (c >= '0' and c <= '9')
+        or c == '+' or c == '/';
+      try
+      {
+        xu::shared_buf decoded = xu::shared_buf::fromBase64(bad);
+        CHECK(valid);
+        CHECK(decoded.toBase64() == bad);
+      }
+      catch (const xu::decode_error& e)
+      {
+        CHECK(not valid);
+        CHECK(e.position() == pos);
+      }
+    }
+  }
+  std::cout << "base64 exhaustive check ok" << std::endl;
+
+  const char* malformed[] = {"Zg=", "Z===", "=g==", "Zh==", "Zm9=", "Zg==Zg==", "Zm9v\n"};
+  for (const char* bad : malformed)
+  {
+    try
+    {
+      xu::shared_buf::fromBase64(bad);
+      CHECK(false);
+    }
+    catch (const xu::decode_error& e)
+    {
+      std::cout << "caught: " << e.what() << std::endl;
+    }
+  }
+}
@@ -0,0 +1,129 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2020 Kevin Xu
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "check.hpp"
+#include "shared_buf_builder.hpp"
+#include "unique_buf.hpp"
+
+int main()
+{
+  xu::shared_buf_builder builder;
+  CHECK(builder.size() == 0 and builder.capacity() == 0);
+
+  const char hello[] = "hello";
+  builder.append(hello, 5);
+  builder.push_back(',');
+
+  xu::shared_buf tail = xu::shared_buf::fromHex("2021");
+  builder.append(tail);
+  builder.append(tail.slice(1));
+
+  xu::unique_buf owned(2);
+  owned[0] = 'o';
+  owned[1] = 'k';
+  builder.append(owned);
+
+#if __cplusplus >= 202002L
+  std::vector<uint8_t> vec = {'.', '.'};
+  builder.append(std::span(vec));
+#endif
+
+  builder[0] = 'H';
+  const uint8_t* bytes = builder.data();
+  size_t length = builder.size();
+
+  xu::shared_buf msg = builder.finish();
+  CHECK(msg.size() == length and msg.data() == bytes);
+  CHECK(builder.size() == 0 and builder.capacity() == 0);
+  std::cout << "msg=" << msg << std::endl;
+
+  /*
+   *  Past the threshold storage is mapped and grows with mremap()
+   */
+  xu::shared_buf_builder big(0, 4096);
+  std::vector<uint8_t> chunk(1000);
+  for (size_t i = 0; i < 100; i++)
+  {
+    std::memset(chunk.data(), (int)i, chunk.size());
+    big.append(chunk.data(), chunk.size());
+  }
+  uint8_t* filled = big.extend(24);
+  std::memset(filled, 0xff, 24);
+  CHECK(big.capacity() >= 100024 and big.capacity() % 4096 == 0);
+
+  xu::shared_buf large = big.finish();
+  CHECK(large.size() == 100024);
+  for (size_t i = 0; i < 100000; i++)
+  {
+    CHECK(large[i] == (uint8_t)(i / 1000));
+  }
+  CHECK(large[100023] == 0xff);
+
+  /*
+   *  Appending the builder's own bytes survives the storage growing under them
+   */
+  xu::shared_buf_builder twice;
+  twice.append(hello, 5);
+  for (size_t i = 0; i < 12; i++)
+  {
+    twice.append(twice.data(), twice.size());
+  }
+  twice.append(twice.data() + 1, 2);
+  xu::shared_buf doubled = twice.finish();
+  CHECK(doubled.size() == (5u << 12) + 2);
+  CHECK(std::memcmp(doubled.data() + (5u << 11), hello, 5) == 0);
+  CHECK(doubled[(5u << 12)] == 'e' and doubled[(5u << 12) + 1] == 'l');
+
+  xu::shared_buf_builder twice_mapped(0, 4096);
+  twice_mapped.append(chunk.data(), chunk.size());
+  for (size_t i = 0; i < 4; i++)
+  {
+    twice_mapped.append(twice_mapped.data(), twice_mapped.size());
+  }
+  CHECK(twice_mapped.size() == 16000 and twice_mapped[15999] == 99);
+
+  xu::shared_buf_builder reserved(64);
+  CHECK(reserved.capacity() >= 64);
+  reserved.push_back(1);
+  reserved.clear();
+  CHECK(reserved.size() == 0);
+  xu::shared_buf_builder moved = std::move(reserved);
+  CHECK(moved.finish().size() == 0);
+  CHECK(xu::shared_buf_builder().finish().size() == 0);
+
+#if XU_SHARED_BUF_CHECK == XU_SHARED_BUF_CHECK_THROW or XU_SHARED_BUF_CHECK == XU_SHARED_BUF_CHECK_HARDENED
+  try
+  {
+    builder[0];
+  }
+  catch (const std::out_of_range& e)
+  {
+    std::cout << "caught: " << e.what() << std::endl;
+  }
+#endif
+}
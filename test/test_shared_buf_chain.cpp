@@ -0,0 +1,117 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2020 Kevin Xu
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+#include <type_traits>
+#include "check.hpp"
+#include "shared_buf_chain.hpp"
+
+static xu::shared_buf fill(size_t sz, uint8_t first)
+{
+  xu::shared_buf buf(sz);
+  for (auto& b : buf)
+  {
+    b = first++;
+  }
+  return buf;
+}
+
+int main()
+{
+  xu::shared_buf_chain chain;
+
+  chain.append(fill(3, 0x10));
+  chain.append(fill(2, 0x20));
+  chain.prepend(fill(1, 0x01));
+  chain.append(xu::shared_buf(0));
+
+  std::cout << "chain=" << chain << " size=" << chain.size()
+    << " segments=" << chain.segments().size() << std::endl;
+  CHECK(chain.size() == 6);
+  CHECK(chain.segments().size() == 3);
+
+  size_t n = 0;
+  for (auto& b : chain)
+  {
+    b += 1;
+    n++;
+  }
+  CHECK(n == chain.size());
+
+  const xu::shared_buf_chain& cchain = chain;
+  xu::shared_buf_chain::const_iterator cit = chain.begin();
+  CHECK(cit == cchain.begin());
+  CHECK(*cit == 0x02);
+  CHECK(chain[4] == 0x21);
+
+  CHECK(std::distance(chain.begin(), chain.end()) == 6);
+  CHECK(std::count(cchain.begin(), cchain.end(), 0x21) == 1);
+  CHECK(std::find(chain.begin(), chain.end(), 0x12).segmentIndex() == 1);
+  static_assert(std::is_same_v<std::iterator_traits<xu::shared_buf_chain::iterator>::iterator_category,
+    std::forward_iterator_tag>);
+#if __cplusplus >= 202002L
+  static_assert(std::forward_iterator<xu::shared_buf_chain::iterator>);
+  static_assert(std::forward_iterator<xu::shared_buf_chain::const_iterator>);
+#endif
+
+  xu::shared_buf_chain tail = chain.split(2);
+  std::cout << "head=" << chain << " tail=" << tail << std::endl;
+  CHECK(chain.size() == 2);
+  CHECK(tail.size() == 4);
+  CHECK(tail[0] == 0x12);
+
+  const uint8_t* tail_first = tail.segments().front().data();
+  xu::shared_buf flat = tail.coalesce();
+  std::cout << "coalesced=" << flat << std::endl;
+  CHECK(flat.size() == 4);
+  CHECK(flat.data() != tail_first);
+  CHECK(tail.segments().size() == 1);
+  CHECK(tail.coalesce().data() == flat.data());
+
+  xu::shared_buf_chain rest = tail.split(4);
+  CHECK(rest.size() == 0);
+  CHECK(rest.begin() == rest.end());
+
+  try
+  {
+    tail.split(5);
+  }
+  catch (const std::out_of_range& e)
+  {
+    std::cout << "caught: " << e.what() << std::endl;
+  }
+
+#if XU_SHARED_BUF_CHECK == XU_SHARED_BUF_CHECK_THROW or XU_SHARED_BUF_CHECK == XU_SHARED_BUF_CHECK_HARDENED
+  try
+  {
+    cchain[6];
+  }
+  catch (const std::out_of_range& e)
+  {
+    std::cout << "caught: " << e.what() << std::endl;
+  }
+#endif
+}
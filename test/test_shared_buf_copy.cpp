@@ -0,0 +1,92 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2020 Kevin Xu
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include <iostream>
+#include <vector>
+
+#include "check.hpp"
+#include "shared_buf.hpp"
+
+static void check(size_t sz, size_t src_offset, const xu::copy_options& opts)
+{
+  std::vector<uint8_t> src(sz + src_offset);
+  std::vector<uint8_t> dst(sz + 1, 0xcc);
+  for (size_t i = 0; i < src.size(); i++)
+  {
+    src[i] = (uint8_t)(i * 7);
+  }
+
+  /* offset the destination by one byte, so the aligning head is exercised */
+  xu::copy_bytes(dst.data() + 1, src.data() + src_offset, sz, opts);
+
+  CHECK(dst[0] == 0xcc);
+  for (size_t i = 0; i < sz; i++)
+  {
+    CHECK(dst[i + 1] == src[i + src_offset]);
+  }
+}
+
+int main()
+{
+  const size_t sizes[] = {0, 1, 15, 64, 127, 4096, 100000, size_t(3) << 20};
+
+  xu::copy_options plain;
+
+  xu::copy_options streaming;
+  streaming.streaming_threshold = 1;
+
+  xu::copy_options threaded;
+  threaded.streaming_threshold = 1;
+  threaded.threads = 3;
+  threaded.parallel_threshold = 1;
+
+  for (size_t sz : sizes)
+  {
+    for (size_t offset = 0; offset < 3; offset++)
+    {
+      check(sz, offset, plain);
+      check(sz, offset, streaming);
+      check(sz, offset, threaded);
+    }
+  }
+  std::cout << "copy_bytes ok" << std::endl;
+
+  xu::shared_buf buf(size_t(5) << 20);
+  for (size_t i = 0; i < buf.size(); i++)
+  {
+    buf[i] = (uint8_t)i;
+  }
+
+  xu::shared_buf copy = buf.deepCopy(threaded);
+  CHECK(copy.size() == buf.size());
+  CHECK(copy.data() != buf.data());
+  for (size_t i = 0; i < buf.size(); i++)
+  {
+    CHECK(copy[i] == buf[i]);
+  }
+  std::cout << "deepCopy ok" << std::endl;
+
+  xu::shared_buf empty(0);
+  CHECK(empty.deepCopy().size() == 0);
+}
@@ -0,0 +1,158 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2020 Kevin Xu
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include <cstdint>
+#include <iostream>
+
+#include "check.hpp"
+#include "shared_buf_cursor.hpp"
+
+int main()
+{
+  xu::shared_buf buf = xu::shared_buf::zeroed(64);
+  xu::buf_writer writer(buf);
+
+  writer.writeU16(0x0102);
+  writer.writeU32<std::endian::little>(0x03040506);
+  writer.writeU64(0x0708090a0b0c0d0e);
+  writer.writeF32(1.5f);
+  writer.writeF64(-2.25);
+  writer.writeVarint(300);
+  writer.writeString("abc");
+  {
+    auto rec = writer.record(3);
+    rec.writeU8(0xaa);
+    rec.writeU16<std::endian::little>(0xccbb);
+  }
+  size_t written = writer.position();
+  std::cout << "written=" << buf.slice(0, written) << std::endl;
+
+  /*
+   *  Byte layout follows the requested order
+   */
+  CHECK(buf[0] == 0x01 and buf[1] == 0x02);
+  CHECK(buf[2] == 0x06 and buf[5] == 0x03);
+  CHECK(buf[6] == 0x07 and buf[13] == 0x0e);
+
+  xu::buf_reader reader(buf.slice(0, written));
+  CHECK(reader.readU16() == 0x0102);
+  CHECK(reader.readU32<std::endian::little>() == 0x03040506);
+  CHECK(reader.readU64() == 0x0708090a0b0c0d0e);
+  CHECK(reader.readF32() == 1.5f);
+  CHECK(reader.readF64() == -2.25);
+  CHECK(reader.readVarint() == 300);
+  CHECK(reader.readString() == "abc");
+  {
+    auto rec = reader.record(3);
+    CHECK(rec.readU8() == 0xaa);
+    CHECK(rec.readU16<std::endian::little>() == 0xccbb);
+    CHECK(rec.remaining() == 0);
+  }
+  CHECK(reader.remaining() == 0);
+
+  try
+  {
+    reader.readU8();
+    CHECK(false);
+  }
+  catch (const std::out_of_range& e)
+  {
+    std::cout << "caught: " << e.what() << std::endl;
+  }
+
+  /*
+   *  Varint edge cases
+   */
+  const uint64_t values[] = {0, 1, 127, 128, 16383, 16384, UINT32_MAX, UINT64_MAX};
+  for (uint64_t v : values)
+  {
+    uint8_t bytes[10];
+    xu::buf_writer<std::endian::little> w(bytes, sizeof(bytes));
+    w.writeVarint(v);
+    xu::buf_reader<std::endian::little> r(xu::shared_buf_view(bytes, w.position()));
+    CHECK(r.readVarint() == v and r.remaining() == 0);
+  }
+
+  const uint8_t too_long[11] = {0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x01};
+  const uint8_t overflow[10] = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x02};
+  const uint8_t truncated[2] = {0x80, 0x80};
+  for (xu::shared_buf_view bad : {xu::shared_buf_view(too_long, 11), xu::shared_buf_view(overflow, 10)})
+  {
+    try
+    {
+      xu::buf_reader(bad).readVarint();
+      CHECK(false);
+    }
+    catch (const xu::decode_error& e)
+    {
+      std::cout << "caught: " << e.what() << std::endl;
+    }
+  }
+  try
+  {
+    xu::buf_reader(xu::shared_buf_view(truncated, 2)).readVarint();
+    CHECK(false);
+  }
+  catch (const std::out_of_range& e)
+  {
+    std::cout << "caught: " << e.what() << std::endl;
+  }
+
+  /*
+   *  Unchecked cursors still check varints, whose length depends on the data
+   */
+  xu::buf_reader fixed(xu::shared_buf_view(truncated, 2));
+  auto unchecked = fixed.record(2);
+  try
+  {
+    unchecked.readVarint();
+    CHECK(false);
+  }
+  catch (const std::out_of_range& e)
+  {
+    std::cout << "caught: " << e.what() << std::endl;
+  }
+  CHECK(unchecked.position() == 0);
+
+  /*
+   *  Writers take slices by value
+   */
+  xu::buf_writer(buf.slice(60, 4)).writeU32(0xdeadbeef);
+  CHECK(buf[60] == 0xde and buf[63] == 0xef);
+
+  /*
+   *  A string that does not fit leaves the writer where it was
+   */
+  xu::buf_writer small(buf.data(), 4);
+  try
+  {
+    small.writeString("toolong");
+    CHECK(false);
+  }
+  catch (const std::out_of_range& e)
+  {
+    std::cout << "caught: " << e.what() << std::endl;
+  }
+  CHECK(small.position() == 0);
+}
@@ -0,0 +1,151 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2020 Kevin Xu
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#include "check.hpp"
+#include "shared_buf.hpp"
+
+/**
+  @brief  Reference formatter: the original per-byte iostream implementation of print()
+  */
+static std::string reference(const xu::shared_buf& buf, bool uppercase)
+{
+  std::ostringstream stream;
+  stream << '[' << std::hex << (uppercase ? std::uppercase : std::nouppercase);
+  for (size_t i = 0; i < buf.size(); i++)
+  {
+    if (i != 0)
+    {
+      stream << ',';
+    }
+    stream << std::setw(2) << std::setfill('0') << (int)buf[i];
+  }
+  stream << ']';
+  return stream.str();
+}
+
+int main()
+{
+  const size_t sizes[] = {0, 1, 15, 16, 17, 1023, 1024, 1025, 3000};
+
+  for (size_t sz : sizes)
+  {
+    xu::shared_buf buf(sz);
+    for (size_t i = 0; i < sz; i++)
+    {
+      buf[i] = (uint8_t)(i * 37 + 11);
+    }
+
+    std::ostringstream printed;
+    printed << buf;
+    CHECK(printed.str() == reference(buf, false));
+
+    xu::hex_format upper;
+    upper.uppercase = true;
+    std::ostringstream printed_upper;
+    buf.print(printed_upper, upper);
+    CHECK(printed_upper.str() == reference(buf, true));
+
+    std::string compact = xu::to_hex(buf.data(), buf.size(), xu::compact_hex());
+    CHECK(compact.size() == 2 * sz);
+    std::ostringstream printed_compact;
+    buf.print(printed_compact, xu::compact_hex());
+    CHECK(printed_compact.str() == compact);
+
+    std::string expected;
+    for (size_t i = 0; i < sz; i++)
+    {
+      expected += reference(buf.slice(i, 1), false).substr(1, 2);
+    }
+    CHECK(compact == expected);
+  }
+
+  /* decoding: round trips, both cases, and every invalid character in every lane */
+  for (size_t sz : sizes)
+  {
+    xu::shared_buf buf(sz);
+    for (size_t i = 0; i < sz; i++)
+    {
+      buf[i] = (uint8_t)(i * 13 + 5);
+    }
+
+    std::string lower = buf.toHex(xu::compact_hex());
+    std::string upper = buf.toHex(xu::compact_hex(true));
+    xu::shared_buf from_lower = xu::shared_buf::fromHex(lower);
+    xu::shared_buf from_upper = xu::shared_buf::fromHex(upper);
+    CHECK(from_lower.size() == sz and from_upper.size() == sz);
+    for (size_t i = 0; i < sz; i++)
+    {
+      CHECK(from_lower[i] == buf[i] and from_upper[i] == buf[i]);
+    }
+  }
+
+  std::string hex(40, 'a');
+  for (size_t pos = 0; pos < hex.size(); pos++)
+  {
+    for (int c = 0; c < 256; c++)
+    {
+      std::string bad = hex;
+      bad[pos] = (char)c;
+      bool valid = (c >= '0' and c <= '9') or (c >= 'a' and c <= 'f') or (c >= 'A' and c <= 'F');
+      try
+      {
+        xu::shared_buf::fromHex(bad);
+        CHECK(valid);
+      }
+      catch (const xu::decode_error& e)
+      {
+        CHECK(not valid);
+        CHECK(e.position() == pos);
+      }
+    }
+  }
+
+  try
+  {
+    xu::shared_buf::fromHex("abc");
+  }
+  catch (const xu::decode_error& e)
+  {
+    std::cout << "caught: " << e.what() << std::endl;
+  }
+
+  xu::shared_buf buf(4);
+  buf[0] = 0x00;
+  buf[1] = 0x7f;
+  buf[2] = 0xab;
+  buf[3] = 0xff;
+
+  std::cout << "default=" << buf << std::endl;
+  std::cout << "upper=";
+  buf.print(std::cout, xu::hex_format{true, ',', true}) << std::endl;
+  std::cout << "compact=" << xu::to_hex(buf.data(), buf.size(), xu::compact_hex()) << std::endl;
+  std::cout << "compact upper=" << xu::to_hex(buf.data(), buf.size(), xu::compact_hex(true)) << std::endl;
+
+  /* stream flags are left untouched */
+  std::cout << std::hex << "flags kept: " << 255 << std::dec << std::endl;
+}
@@ -0,0 +1,192 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2020 Kevin Xu
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+#include "check.hpp"
+#include "shared_buf_intrusive.hpp"
+
+static_assert(sizeof(xu::local_shared_buf) == sizeof(void*));
+static_assert(sizeof(xu::compact_shared_buf) == sizeof(void*));
+static_assert(sizeof(xu::compact_shared_slice) == 2 * sizeof(void*));
+
+/* when set, the next global operator new throws, to reach share()'s failure path */
+static bool fail_next_new = false;
+
+void* operator new(size_t n)
+{
+  if (fail_next_new)
+  {
+    fail_next_new = false;
+    throw std::bad_alloc();
+  }
+  if (void* p = std::malloc(n == 0 ? 1 : n))
+  {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+  std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+  std::free(p);
+}
+
+int main()
+{
+  xu::local_shared_buf buf(6);
+  std::iota(buf.begin(), buf.end(), 1);
+  std::cout << "local=" << buf << std::endl;
+  CHECK(buf.use_count() == 1);
+
+  {
+    xu::local_shared_buf copy = buf;
+    std::vector<xu::local_shared_buf> copies(3, buf);
+    CHECK(buf.use_count() == 5);
+    copy[0] = 0xaa;
+    CHECK(buf[0] == 0xaa);
+  }
+  CHECK(buf.use_count() == 1);
+
+  xu::shared_buf_view view = buf;
+  CHECK(view.size() == 6 and view.data() == buf.data());
+
+  /*
+   *  Crossing threads requires giving up the last local handle
+   */
+  xu::local_shared_buf other = buf;
+  try
+  {
+    std::move(buf).share();
+    CHECK(false);
+  }
+  catch (const std::logic_error& e)
+  {
+    std::cout << "caught: " << e.what() << std::endl;
+  }
+  other = xu::local_shared_buf(1);
+  CHECK(buf.use_count() == 1);
+
+  /* a share() that cannot allocate its control block leaves the buffer as it was */
+  try
+  {
+    fail_next_new = true;
+    std::move(buf).share();
+  }
+  catch (const std::bad_alloc&)
+  {
+    std::cout << "caught: bad_alloc" << std::endl;
+  }
+  fail_next_new = false;
+  CHECK(buf.size() == 6 and buf.use_count() == 1 and buf[5] == 6);
+
+  const uint8_t* bytes = buf.data();
+  xu::shared_buf shared = std::move(buf).share();
+  CHECK(shared.data() == bytes);
+  CHECK(shared.size() == 6);
+  CHECK(buf.size() == 0 and buf.use_count() == 0);
+
+  std::thread([shared]()
+  {
+    std::cout << "shared=" << shared << std::endl;
+  }).join();
+
+  xu::local_shared_buf moved(3);
+  moved = std::move(other);
+  CHECK(moved.size() == 1);
+  moved = moved;
+  CHECK(moved.use_count() == 1);
+
+  try
+  {
+    moved.at(1);
+  }
+  catch (const std::out_of_range& e)
+  {
+    std::cout << "caught: " << e.what() << std::endl;
+  }
+
+  try
+  {
+    xu::local_shared_buf huge(SIZE_MAX);
+  }
+  catch (const std::bad_alloc&)
+  {
+    std::cout << "caught: bad_alloc" << std::endl;
+  }
+
+  /*
+   *  Compact buffers count atomically, so copies may cross threads
+   */
+  xu::compact_shared_buf compact(8);
+  std::iota(compact.begin(), compact.end(), 0);
+
+  xu::compact_shared_slice window = compact.slice(2, 4);
+  xu::compact_shared_slice inner = window.slice(1);
+  std::cout << "window=" << window << " inner=" << inner << std::endl;
+  CHECK(inner.size() == 3 and inner[0] == 3);
+  CHECK(xu::shared_buf_view(inner) == compact.slice(3, 3));
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++)
+  {
+    threads.emplace_back([compact, window]()
+    {
+      for (int i = 0; i < 10000; i++)
+      {
+        xu::compact_shared_buf copy = compact;
+        xu::compact_shared_slice sub = window.slice(i % 4);
+        CHECK(sub.size() == 4 - (size_t)(i % 4));
+      }
+    });
+  }
+  for (auto& th : threads)
+  {
+    th.join();
+  }
+  CHECK(compact.use_count() == 3);
+
+  compact = xu::compact_shared_buf(0);
+  CHECK(window[3] == 5);
+  CHECK(window.use_count() == 2);
+
+  try
+  {
+    window.slice(2, 3);
+  }
+  catch (const std::out_of_range& e)
+  {
+    std::cout << "caught: " << e.what() << std::endl;
+  }
+}
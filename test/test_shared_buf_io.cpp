@@ -0,0 +1,152 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2020 Kevin Xu
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "check.hpp"
+#include "shared_buf_io.hpp"
+
+static xu::shared_buf fill(size_t sz, uint8_t first)
+{
+  xu::shared_buf buf(sz);
+  for (auto& b : buf)
+  {
+    b = first++;
+  }
+  return buf;
+}
+
+int main()
+{
+  /* pipe: single buffers */
+  {
+    int fds[2];
+    int rc = ::pipe(fds);
+    CHECK(rc == 0);
+
+    xu::shared_buf out = fill(8, 1);
+    size_t written = xu::write_to(fds[1], out);
+    CHECK(written == 8);
+
+    xu::shared_buf in(8);
+    size_t got = xu::read_from(fds[0], in);
+    CHECK(got == 8);
+    std::cout << "pipe=" << in << std::endl;
+
+    ::close(fds[1]);
+    xu::shared_buf eof(4);
+    got = xu::read_from(fds[0], eof);
+    CHECK(got == 0);
+    ::close(fds[0]);
+  }
+
+  /* regular file: many fragments, more than one writev batch */
+  {
+    FILE* f = std::tmpfile();
+    int fd = ::fileno(f);
+
+    std::vector<xu::shared_buf> frags;
+    size_t total = 0;
+    for (size_t i = 0; i < 1000; i++)
+    {
+      frags.push_back(fill(1 + i % 7, (uint8_t)i));
+      total += frags.back().size();
+    }
+    size_t written = xu::write_to(fd, frags);
+    CHECK(written == total);
+
+    ::lseek(fd, 0, SEEK_SET);
+    xu::shared_buf whole(total);
+    size_t got = xu::read_from(fd, whole);
+    CHECK(got == total);
+
+    size_t pos = 0;
+    for (const auto& frag : frags)
+    {
+      for (auto b : frag)
+      {
+        CHECK(whole[pos++] == b);
+      }
+    }
+    std::cout << "file: " << total << " bytes in " << frags.size() << " fragments" << std::endl;
+
+    std::fclose(f);
+  }
+
+  /* socketpair: chains in both directions */
+  {
+    int fds[2];
+    int rc = ::socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+    CHECK(rc == 0);
+
+    xu::shared_buf_chain out;
+    out.append(fill(2, 0x10));
+    out.append(fill(3, 0x20));
+    out.append(fill(1, 0x30));
+    size_t written = xu::write_to(fds[0], out);
+    CHECK(written == 6);
+
+    xu::shared_buf_chain in;
+    in.append(xu::shared_buf(4));
+    in.append(xu::shared_buf(2));
+    size_t got = xu::read_from(fds[1], in);
+    CHECK(got == 6);
+    std::cout << "socketpair=" << in << std::endl;
+
+    ::close(fds[0]);
+    ::close(fds[1]);
+  }
+
+  /* non-blocking pipe: a write that would block reports a partial count */
+  {
+    int fds[2];
+    int rc = ::pipe(fds);
+    CHECK(rc == 0);
+    ::fcntl(fds[1], F_SETFL, O_NONBLOCK);
+
+    xu::shared_buf big(1 << 22);
+    size_t written = xu::write_to(fds[1], big);
+    CHECK(written > 0 and written < big.size());
+    std::cout << "non-blocking partial write=" << written << std::endl;
+
+    ::close(fds[0]);
+    ::close(fds[1]);
+  }
+
+  try
+  {
+    xu::shared_buf buf(1);
+    xu::write_to(-1, buf);
+  }
+  catch (const std::system_error& e)
+  {
+    std::cout << "caught: " << e.what() << std::endl;
+  }
+}
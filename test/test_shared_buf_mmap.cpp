@@ -0,0 +1,103 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2020 Kevin Xu
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+#include <unistd.h>
+
+#include "check.hpp"
+#include "shared_buf_mmap.hpp"
+
+int main()
+{
+  char path[] = "/tmp/test_shared_buf_mmap_XXXXXX";
+  int fd = ::mkstemp(path);
+  CHECK(fd >= 0);
+
+  const size_t sz = 3 * 4096 + 10;
+  for (size_t i = 0; i < sz; i++)
+  {
+    uint8_t b = (uint8_t)i;
+    ssize_t written = ::write(fd, &b, 1);
+    CHECK(written == 1);
+  }
+  ::close(fd);
+
+  {
+    xu::map_options opts;
+    opts.populate = true;
+    opts.advice = xu::map_advice::sequential;
+
+    xu::shared_buf whole = xu::map_file(path, opts);
+    CHECK(whole.size() == sz);
+    CHECK(whole[4097] == (uint8_t)4097);
+    std::cout << "whole: " << whole.size() << " bytes" << std::endl;
+  }
+
+  {
+    xu::map_options opts;
+    opts.offset = 4100;
+    opts.length = 6;
+
+    xu::shared_buf window = xu::map_file(path, opts);
+    std::cout << "window=" << window << std::endl;
+    CHECK(window[0] == (uint8_t)4100);
+  }
+
+  {
+    xu::map_options opts;
+    opts.writable = true;
+
+    xu::shared_buf priv = xu::map_file(path, opts);
+    priv[0] = 0xff;
+
+    xu::shared_buf again = xu::map_file(path);
+    CHECK(again[0] == 0);
+    std::cout << "private write not visible in file" << std::endl;
+  }
+
+  try
+  {
+    xu::map_options opts;
+    opts.offset = sz + 1;
+    xu::map_file(path, opts);
+  }
+  catch (const std::out_of_range& e)
+  {
+    std::cout << "caught: " << e.what() << std::endl;
+  }
+
+  ::unlink(path);
+
+  try
+  {
+    xu::map_file(path);
+  }
+  catch (const std::system_error& e)
+  {
+    std::cout << "caught: " << e.what() << std::endl;
+  }
+}
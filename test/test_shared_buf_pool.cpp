@@ -0,0 +1,129 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2020 Kevin Xu
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include <future>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "check.hpp"
+#include "shared_buf_pool.hpp"
+
+/*
+ *  A static pool outlives the main thread's registry, and so does a buffer released
+ *  from another static destructor
+ */
+xu::buf_pool static_pool;
+
+struct late_release
+{
+  xu::shared_buf buf{0};
+} late;
+
+int main()
+{
+  xu::buf_pool pool;
+
+  {
+    xu::shared_buf buf = xu::make_shared_buf(8, pool);
+
+    int counter = 0;
+    for (auto& b : buf)
+    {
+      b = ++counter;
+    }
+
+    std::cout << "pooled=" << buf << std::endl;
+  }
+
+  /* the block freed above should be reused from the thread cache */
+  {
+    xu::shared_buf buf = pool.make(8);
+    CHECK(buf.size() == 8);
+  }
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++)
+  {
+    threads.emplace_back([&pool]()
+    {
+      std::vector<xu::shared_buf> held;
+      for (int i = 0; i < 1000; i++)
+      {
+        held.push_back(pool.make(64 << (i % 8)));
+        if (held.size() > 100)
+        {
+          held.clear();
+        }
+      }
+    });
+  }
+  for (auto& th : threads)
+  {
+    th.join();
+  }
+
+  xu::buf_pool::stats st = pool.getStats();
+  std::cout << "allocations=" << st.allocations
+    << " deallocations=" << st.deallocations
+    << " cache_hits=" << st.cache_hits
+    << " depot_hits=" << st.depot_hits
+    << " system_allocations=" << st.system_allocations
+    << " depot_bytes=" << st.depot_bytes << std::endl;
+
+  CHECK(st.allocations == st.deallocations);
+  CHECK(st.cache_hits > 0);
+
+  pool.trim();
+  CHECK(pool.getStats().depot_bytes == 0);
+
+  std::cout << "trimmed depot_bytes=" << pool.getStats().depot_bytes << std::endl;
+
+  /*
+   *  Short-lived pools leave nothing behind, on their own thread or on others
+   */
+  for (int i = 0; i < 1000; i++)
+  {
+    xu::buf_pool scratch;
+    scratch.make(100);
+  }
+
+  auto dying = std::make_unique<xu::buf_pool>();
+  std::promise<void> cached, destroyed;
+  std::thread worker([&]()
+  {
+    dying->make(256);
+    cached.set_value();
+    destroyed.get_future().wait();
+    /* drops the dead pool's cache, and the block in it */
+    CHECK(pool.make(256).size() == 256);
+  });
+  cached.get_future().wait();
+  dying.reset();
+  destroyed.set_value();
+  worker.join();
+
+  static_pool.make(64);
+  late.buf = static_pool.make(32);
+}
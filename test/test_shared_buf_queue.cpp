@@ -0,0 +1,131 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2020 Kevin Xu
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "check.hpp"
+#include "shared_buf_queue.hpp"
+
+int main()
+{
+  xu::buf_queue queue(3);
+  CHECK(queue.capacity() == 4);
+
+  xu::shared_buf buf = xu::make_shared_buf(2);
+  buf[0] = 1;
+  buf[1] = 2;
+  const uint8_t* bytes = buf.data();
+
+  /*
+   *  Buffers move through without touching the refcount
+   */
+  CHECK(queue.tryPush(std::move(buf)));
+  xu::shared_buf out(0, nullptr);
+  CHECK(queue.tryPop(out));
+  CHECK(out.data() == bytes and out.use_count() == 1);
+  std::cout << "popped=" << out << std::endl;
+  CHECK(not queue.tryPop(out));
+
+  std::vector<xu::shared_buf> batch;
+  for (int i = 0; i < 6; i++)
+  {
+    batch.push_back(xu::make_shared_buf(1));
+    batch.back()[0] = (uint8_t)i;
+  }
+  CHECK(queue.tryPushBatch(batch.data(), batch.size()) == 4);
+  CHECK(batch[4].size() == 1 and batch[4][0] == 4);
+  CHECK(not queue.tryPush(std::move(batch[4])));
+  CHECK(batch[4].size() == 1);
+
+  std::vector<xu::shared_buf> popped(6, xu::shared_buf(0, nullptr));
+  CHECK(queue.tryPopBatch(popped.data(), 3) == 3);
+  CHECK(popped[0][0] == 0 and popped[2][0] == 2);
+  CHECK(queue.tryPushBatch(batch.data() + 4, 2) == 2);
+  CHECK(queue.tryPopBatch(popped.data(), 6) == 3);
+  CHECK(popped[0][0] == 3 and popped[1][0] == 4 and popped[2][0] == 5);
+
+  {
+    /* destroyed with a buffer still queued */
+    xu::buf_queue leftover(2);
+    CHECK(leftover.tryPush(xu::make_shared_buf(8)));
+  }
+
+  /*
+   *  Several producers and consumers; every buffer arrives exactly once
+   */
+  const size_t producers = 4;
+  const size_t consumers = 4;
+  const size_t per_producer = 20000;
+  xu::buf_queue shared(64);
+  std::vector<std::atomic<int>> seen(producers * per_producer);
+
+  std::vector<std::thread> threads;
+  for (size_t p = 0; p < producers; p++)
+  {
+    threads.emplace_back([&, p]()
+    {
+      for (size_t i = 0; i < per_producer; i++)
+      {
+        xu::shared_buf msg = xu::make_shared_buf(sizeof(uint32_t));
+        *(uint32_t*)msg.data() = (uint32_t)(p * per_producer + i);
+        while (not shared.tryPush(std::move(msg)))
+        {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  std::atomic<size_t> received{0};
+  for (size_t c = 0; c < consumers; c++)
+  {
+    threads.emplace_back([&]()
+    {
+      std::vector<xu::shared_buf> msgs(8, xu::shared_buf(0, nullptr));
+      while (received.load() < producers * per_producer)
+      {
+        size_t n = shared.tryPopBatch(msgs.data(), msgs.size());
+        for (size_t i = 0; i < n; i++)
+        {
+          seen[*(const uint32_t*)msgs[i].data()]++;
+        }
+        received += n;
+        if (n == 0)
+        {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (auto& th : threads)
+  {
+    th.join();
+  }
+  for (auto& count : seen)
+  {
+    CHECK(count == 1);
+  }
+  std::cout << "received=" << received.load() << std::endl;
+}
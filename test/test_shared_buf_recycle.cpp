@@ -0,0 +1,111 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2020 Kevin Xu
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "check.hpp"
+#include "shared_buf_recycle.hpp"
+
+int main()
+{
+  xu::recycling_pool::config cfg;
+  cfg.block_size = 9216;
+  cfg.max_pooled_bytes = 2 * 9216;
+  xu::recycling_pool pool(cfg);
+
+  xu::shared_buf frame = pool.make();
+  CHECK(frame.size() == 9216 and frame.alignment() >= 64);
+  CHECK(pool.owns(frame) and pool.owns(frame.slice(10, 20)));
+  CHECK(not pool.owns(xu::make_shared_buf(8)));
+
+  /*
+   *  The block freed last is handed out first
+   */
+  const uint8_t* block = frame.data();
+  xu::shared_buf copy = frame;
+  frame = xu::make_shared_buf(0);
+  CHECK(pool.getStats().recycled == 0);
+  copy = xu::make_shared_buf(0);
+  CHECK(pool.getStats().recycled == 1);
+
+  xu::shared_buf reused = pool.make(1500);
+  CHECK(reused.data() == block and reused.size() == 1500);
+
+  /*
+   *  Beyond max_pooled_bytes, blocks go back to the system
+   */
+  {
+    std::vector<xu::shared_buf> burst;
+    for (int i = 0; i < 4; i++)
+    {
+      burst.push_back(pool.make());
+    }
+  }
+  xu::recycling_pool::stats st = pool.getStats();
+  std::cout << "allocations=" << st.allocations << " hits=" << st.hits << " misses=" << st.misses
+    << " recycled=" << st.recycled << " discarded=" << st.discarded
+    << " pooled_bytes=" << st.pooled_bytes << " hit_rate=" << st.hitRate() << std::endl;
+  CHECK(st.allocations == 6 and st.hits == 1 and st.misses == 5);
+  CHECK(st.discarded == 2 and st.pooled_bytes == 2 * 9216);
+
+  try
+  {
+    pool.make(9217);
+  }
+  catch (const std::length_error& e)
+  {
+    std::cout << "caught: " << e.what() << std::endl;
+  }
+
+  /*
+   *  Threads allocate and drop buffers concurrently
+   */
+  {
+    cfg.prefill = 8;
+    xu::recycling_pool shared(cfg);
+    CHECK(shared.getStats().pooled_bytes == 2 * 9216);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++)
+    {
+      threads.emplace_back([&shared]()
+      {
+        for (int i = 0; i < 10000; i++)
+        {
+          xu::shared_buf buf = shared.make(64);
+          buf[0] = (uint8_t)i;
+          xu::shared_buf slice = buf.slice(1, 8);
+        }
+      });
+    }
+    for (auto& th : threads)
+    {
+      th.join();
+    }
+    CHECK(shared.getStats().allocations == 40000);
+    CHECK(shared.getStats().allocations == shared.getStats().hits + shared.getStats().misses);
+  }
+}
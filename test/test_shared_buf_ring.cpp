@@ -0,0 +1,249 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2020 Kevin Xu
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+#include "check.hpp"
+#include "shared_buf_ring.hpp"
+
+/**
+  @brief  Streams a counting byte sequence from a producer to a consumer thread
+  */
+static void stream(xu::spsc_ring& ring, size_t total)
+{
+  std::thread producer([&]()
+  {
+    uint8_t chunk[97];
+    for (size_t sent = 0; sent < total; )
+    {
+      size_t n = std::min(sizeof(chunk), total - sent);
+      for (size_t i = 0; i < n; i++)
+      {
+        chunk[i] = (uint8_t)(sent + i);
+      }
+      size_t staged = ring.write(chunk, n);
+      sent += staged;
+      ring.commit();
+      if (staged == 0)
+      {
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  size_t received = 0;
+  while (received < total)
+  {
+    xu::shared_buf slice = ring.read(61);
+    for (size_t i = 0; i < slice.size(); i++)
+    {
+      CHECK(slice[i] == (uint8_t)(received + i));
+    }
+    received += slice.size();
+    ring.release();
+    if (slice.size() == 0)
+    {
+      std::this_thread::yield();
+    }
+  }
+
+  producer.join();
+}
+
+/**
+  @brief  As stream(), but the producer only stages with prepare(), so that without a
+          mirror it pads the end of the ring, and the consumer alternates slices and copies
+  */
+static void streamPrepared(xu::spsc_ring& ring, size_t total)
+{
+  std::thread producer([&]()
+  {
+    for (size_t sent = 0; sent < total; )
+    {
+      size_t n = std::min(1 + sent % 13, total - sent);
+      uint8_t* bytes = ring.prepare(n);
+      if (bytes == nullptr)
+      {
+        std::this_thread::yield();
+        continue;
+      }
+      for (size_t i = 0; i < n; i++)
+      {
+        bytes[i] = (uint8_t)(sent + i);
+      }
+      sent += n;
+      ring.commit();
+    }
+  });
+
+  size_t received = 0;
+  uint8_t out[7];
+  while (received < total)
+  {
+    size_t got;
+    if (received % 2 == 0)
+    {
+      xu::shared_buf slice = ring.read(5);
+      std::memcpy(out, slice.data(), slice.size());
+      got = slice.size();
+    }
+    else
+    {
+      got = ring.read(out, sizeof(out));
+    }
+    for (size_t i = 0; i < got; i++)
+    {
+      CHECK(out[i] == (uint8_t)(received + i));
+    }
+    received += got;
+    ring.release();
+    if (got == 0)
+    {
+      std::this_thread::yield();
+    }
+  }
+
+  producer.join();
+}
+
+int main()
+{
+  xu::spsc_ring ring(10);
+  CHECK(ring.capacity() == 16 and not ring.isMirrored());
+  CHECK(ring.writable() == 16 and ring.readable() == 0);
+
+  /*
+   *  Staged bytes stay invisible until committed
+   */
+  size_t staged = ring.write("abcdefghijkl", 12);
+  CHECK(staged == 12);
+  CHECK(ring.readable() == 0);
+  ring.commit();
+  CHECK(ring.readable() == 12);
+
+  xu::shared_buf first = ring.read(8);
+  std::cout << "first=" << first << std::endl;
+  CHECK(ring.writable() == 4);
+  ring.release();
+  CHECK(ring.writable() == 12);
+
+  /*
+   *  Without a mirror, reads and prepares stop at the end of the ring
+   */
+  CHECK(ring.prepare(17) == nullptr);
+  std::memcpy(ring.prepare(4), "mnop", 4);
+  staged = ring.write("qrstuvwxyz", 10);
+  CHECK(staged == 8);
+  ring.commit();
+
+  xu::shared_buf tail = ring.read();
+  xu::shared_buf head = ring.read();
+  std::cout << "tail=" << tail << " head=" << head << std::endl;
+  CHECK(tail.size() == 8 and head.size() == 8);
+  CHECK(std::memcmp(head.data(), "qrstuvwx", 8) == 0);
+
+  char out[16];
+  ring.release();
+  size_t got = ring.read(out, sizeof(out));
+  CHECK(got == 0);
+
+  /*
+   *  A prepare() that does not fit before the end pads it, and the consumer skips the padding
+   */
+  xu::spsc_ring padded(16);
+  std::memcpy(padded.prepare(10), "0123456789", 10);
+  padded.commit();
+  padded.read(out, 10);
+  padded.release();
+
+  uint8_t* restarted = padded.prepare(8);
+  CHECK(restarted != nullptr and padded.writable() == 2);
+  std::memcpy(restarted, "ABCDEFGH", 8);
+  padded.commit();
+  CHECK(padded.readable() == 8);
+  xu::shared_buf after_pad = padded.read();
+  CHECK(after_pad.size() == 8 and std::memcmp(after_pad.data(), "ABCDEFGH", 8) == 0);
+  padded.release();
+  CHECK(padded.writable() == 16);
+  CHECK(padded.prepare(17) == nullptr);
+
+  /* read() straight after the padded commit must skip the padding before slicing */
+  xu::spsc_ring direct(16);
+  std::memcpy(direct.prepare(10), "0123456789", 10);
+  direct.commit();
+  direct.read(out, 10);
+  direct.release();
+  std::memcpy(direct.prepare(8), "ABCDEFGH", 8);
+  direct.commit();
+  xu::shared_buf direct_read = direct.read();
+  CHECK(direct_read.size() == 8 and std::memcmp(direct_read.data(), "ABCDEFGH", 8) == 0);
+  CHECK(direct.read().size() == 0);
+
+  /* without room for the padding and the bytes, the padding goes first, published at once */
+  std::memcpy(padded.prepare(8), "IJKLMNOP", 8);
+  padded.commit();
+  padded.read();
+  padded.release();
+  std::memcpy(padded.prepare(12), "0123456789ab", 12);
+  padded.commit();
+  uint8_t* deferred = padded.prepare(8);
+  CHECK(deferred == nullptr and padded.writable() == 0);
+  got = padded.read(out, sizeof(out));
+  CHECK(got == 12);
+  padded.release();
+  std::memcpy(padded.prepare(8), "QRSTUVWX", 8);
+  padded.commit();
+  xu::shared_buf at_start = padded.read();
+  CHECK(at_start.size() == 8 and at_start[0] == 'Q');
+  padded.release();
+
+  /*
+   *  With a mirror, the same window is contiguous
+   */
+  xu::spsc_ring mirrored(1, true);
+  size_t cap = mirrored.capacity();
+  CHECK(mirrored.isMirrored() and cap >= 4096);
+
+  mirrored.prepare(cap - 2);
+  mirrored.commit();
+  mirrored.read(cap - 2);
+  mirrored.release();
+
+  staged = mirrored.write("wrapping", 8);
+  CHECK(staged == 8);
+  mirrored.commit();
+  xu::shared_buf wrapped = mirrored.read();
+  CHECK(wrapped.size() == 8 and std::memcmp(wrapped.data(), "wrapping", 8) == 0);
+  std::cout << "wrapped=" << wrapped << std::endl;
+  mirrored.release();
+
+  stream(ring, 1 << 20);
+  stream(mirrored, 1 << 22);
+  streamPrepared(ring, 1 << 20);
+  streamPrepared(padded, 1 << 20);
+  streamPrepared(mirrored, 1 << 20);
+  std::cout << "streamed" << std::endl;
+}
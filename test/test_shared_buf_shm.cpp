@@ -0,0 +1,223 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2020 Kevin Xu
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include <csignal>
+#include <cstring>
+#include <iostream>
+
+#include <dirent.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "check.hpp"
+#include "shared_buf_shm.hpp"
+
+/**
+  @brief  Returns the number of open descriptors
+  */
+static int openFds()
+{
+  int count = 0;
+  DIR* dir = ::opendir("/proc/self/fd");
+  while (::readdir(dir) != nullptr)
+  {
+    count++;
+  }
+  ::closedir(dir);
+  return count;
+}
+
+/**
+  @brief  Runs fn in a child process and returns its exit status
+  */
+template<typename Fn>
+static int inChild(Fn&& fn)
+{
+  pid_t pid = ::fork();
+  if (pid == 0)
+  {
+    int res = 1;
+    try
+    {
+      res = fn();
+    }
+    catch (const std::exception& e)
+    {
+      std::cout << "child caught: " << e.what() << std::endl;
+    }
+    std::cout.flush();
+    ::_exit(res);
+  }
+
+  int status = 0;
+  ::waitpid(pid, &status, 0);
+  return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+int main()
+{
+  int socks[2];
+  int rc = ::socketpair(AF_UNIX, SOCK_STREAM, 0, socks);
+  CHECK(rc == 0);
+
+  xu::shared_buf buf = xu::make_shm_buf(10000, "test_shared_buf_shm");
+  CHECK(xu::is_shm_buf(buf));
+  CHECK(not xu::is_shm_buf(xu::shared_buf(1)));
+
+  for (size_t i = 0; i < buf.size(); i++)
+  {
+    buf[i] = (uint8_t)i;
+  }
+
+  /* unsealed slice: the child maps the same pages and writes back through them */
+  xu::shared_buf window = buf.slice(5000, 4);
+  xu::shm_handle h = xu::export_shm(window);
+  CHECK(h.offset == 5000 and h.size == 4);
+
+  xu::send_shm(socks[0], window);
+  int status = inChild([&]()
+  {
+    xu::shared_buf got = xu::recv_shm(socks[1]);
+    std::cout << "child received=" << got << std::endl;
+    if (got.size() != 4 or got[0] != (uint8_t)5000)
+    {
+      return 1;
+    }
+    got[0] = 0xee;
+    return 0;
+  });
+  CHECK(status == 0);
+  std::cout << "parent sees child write=" << window << std::endl;
+  CHECK(window[0] == 0xee);
+
+  /* a receiver that requires sealing rejects unsealed buffers */
+  xu::send_shm(socks[0], buf);
+  status = inChild([&]()
+  {
+    try
+    {
+      xu::recv_shm(socks[1], true);
+    }
+    catch (const std::system_error& e)
+    {
+      std::cout << "child rejected: " << e.what() << std::endl;
+      return 0;
+    }
+    return 1;
+  });
+  CHECK(status == 0);
+
+  /* sealing fails while another writable mapping exists, and leaves the buffer writable */
+  void* other = ::mmap(nullptr, 4096, PROT_READ | PROT_WRITE, MAP_SHARED, xu::export_shm(buf).fd, 0);
+  CHECK(other != MAP_FAILED);
+  try
+  {
+    xu::seal_shm(buf);
+    CHECK(false);
+  }
+  catch (const std::system_error& e)
+  {
+    std::cout << "caught: " << e.what() << std::endl;
+  }
+  ::munmap(other, 4096);
+  CHECK(not xu::is_sealed_shm(xu::export_shm(buf).fd));
+  buf[5001] = 0xef;
+
+  /* sealed buffers are immutable for everyone, and importable read-only */
+  xu::seal_shm(buf);
+  CHECK(xu::is_sealed_shm(xu::export_shm(buf).fd));
+  CHECK(buf[5000] == 0xee);
+
+  xu::send_shm(socks[0], buf);
+  status = inChild([&]()
+  {
+    xu::shared_buf got = xu::recv_shm(socks[1], true);
+    return (got.size() == 10000 and got[1] == 1) ? 0 : 1;
+  });
+  CHECK(status == 0);
+  std::cout << "sealed buffer received" << std::endl;
+
+  status = inChild([&]()
+  {
+    ::signal(SIGSEGV, SIG_DFL);
+    buf[0] = 1;
+    return 0;
+  });
+  CHECK(status == -1);
+  std::cout << "write to sealed buffer faults" << std::endl;
+
+  try
+  {
+    xu::export_shm(xu::shared_buf(1));
+  }
+  catch (const std::invalid_argument& e)
+  {
+    std::cout << "caught: " << e.what() << std::endl;
+  }
+
+  /* descriptors beyond the first are closed, not leaked */
+  {
+    uint64_t header[2] = {0, 16};
+    struct iovec iov = {header, sizeof(header)};
+    int fds[2] = {xu::export_shm(buf).fd, ::dup(0)};
+    alignas(struct cmsghdr) char control[CMSG_SPACE(sizeof(fds))];
+    std::memset(control, 0, sizeof(control));
+
+    struct msghdr msg;
+    std::memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+    std::memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+    ssize_t sent = ::sendmsg(socks[0], &msg, 0);
+    CHECK(sent == (ssize_t)sizeof(header));
+    ::close(fds[1]);
+
+    int before = openFds();
+    xu::shared_buf got = xu::recv_shm(socks[1]);
+    CHECK(got.size() == 16 and got[1] == 1);
+    CHECK(openFds() == before + 1);
+  }
+
+  /* a closed peer is reported as such */
+  ::close(socks[0]);
+  try
+  {
+    xu::recv_shm(socks[1]);
+    CHECK(false);
+  }
+  catch (const std::system_error& e)
+  {
+    CHECK(e.code() == std::errc::not_connected);
+    std::cout << "caught: " << e.what() << std::endl;
+  }
+  ::close(socks[1]);
+}
@@ -0,0 +1,107 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2020 Kevin Xu
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include <cstring>
+#include <iostream>
+#include <numeric>
+
+#include "check.hpp"
+#include "shared_buf_snapshot.hpp"
+
+int main()
+{
+  const size_t page = (size_t)::sysconf(_SC_PAGESIZE);
+  const size_t sz = 4 * page + 100;
+
+  xu::shared_buf live = xu::make_snapshot_buf(sz);
+  CHECK(xu::is_snapshot_buf(live) and live.size() == sz);
+  CHECK(live[sz - 1] == 0);
+  std::iota(live.begin(), live.end(), 0);
+
+  /*
+   *  The first copy freezes the file; writes on either side then stay private
+   */
+  xu::shared_buf snap1 = live.deepCopy();
+  CHECK(xu::is_snapshot_buf(snap1));
+  CHECK(snap1.data() != live.data());
+  CHECK(std::memcmp(snap1.data(), live.data(), sz) == 0);
+
+  live[1] = 0xaa;
+  live[3 * page] = 0xbb;
+  snap1[2] = 0xcc;
+  CHECK(snap1[1] == 1 and snap1[3 * page] == (uint8_t)(3 * page));
+  CHECK(live[2] == 2);
+
+  /*
+   *  Later copies carry over the pages written since
+   */
+  xu::shared_buf snap2 = live.deepCopy();
+  CHECK(std::memcmp(snap2.data(), live.data(), sz) == 0);
+  live[1] = 0;
+  CHECK(snap2[1] == 0xaa and snap2[3 * page] == 0xbb);
+
+  xu::shared_buf snap3 = snap1.deepCopy();
+  CHECK(std::memcmp(snap3.data(), snap1.data(), sz) == 0);
+  CHECK(snap3[2] == 0xcc);
+
+  /*
+   *  Slices copy just their window, from an unaligned offset
+   */
+  xu::shared_buf window = snap2.slice(page - 3, page + 10);
+  xu::shared_buf window_copy = window.deepCopy();
+  CHECK(window_copy.size() == window.size());
+  CHECK(std::memcmp(window_copy.data(), window.data(), window.size()) == 0);
+  std::cout << "window=" << window_copy.slice(0, 8) << std::endl;
+
+  /*
+   *  A copy of a slice is mapped part-way into the file; copying it again must keep its place
+   */
+  xu::shared_buf pages = xu::make_snapshot_buf(3 * page);
+  std::memset(pages.data(), 'A', page);
+  std::memset(pages.data() + page, 'B', page);
+  std::memset(pages.data() + 2 * page, 'C', page);
+  xu::shared_buf middle = pages.slice(page, page).deepCopy();
+  CHECK(middle[0] == 'B');
+  xu::shared_buf middle_again = middle.deepCopy();
+  CHECK(middle_again.size() == page);
+  CHECK(middle_again[0] == 'B' and middle_again[page - 1] == 'B');
+  middle[5] = 'b';
+  xu::shared_buf tail = middle.slice(3, page - 3).deepCopy().deepCopy();
+  CHECK(tail[0] == 'B' and tail[2] == 'b' and tail[page - 4] == 'B');
+
+  xu::shared_buf empty = xu::make_snapshot_buf(0).deepCopy();
+  CHECK(empty.size() == 0);
+
+  /* windows at the very end of a copy, empty or within its last page */
+  xu::shared_buf at_end = middle.slice(page).deepCopy();
+  CHECK(at_end.size() == 0);
+  xu::shared_buf last = snap3.slice(sz - 10).deepCopy();
+  CHECK(last.size() == 10 and std::memcmp(last.data(), snap3.data() + sz - 10, 10) == 0);
+
+  xu::shared_buf plain = xu::make_shared_buf(4).deepCopy();
+  CHECK(not xu::is_snapshot_buf(plain));
+
+  std::cout << "live=" << live.slice(0, 4) << " snap1=" << snap1.slice(0, 4)
+    << " snap2=" << snap2.slice(0, 4) << std::endl;
+}
@@ -0,0 +1,101 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2020 Kevin Xu
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include <iostream>
+#include <numeric>
+#include <type_traits>
+#include <unordered_set>
+
+#include "check.hpp"
+#include "shared_buf_view.hpp"
+
+static_assert(std::is_trivially_copyable_v<xu::shared_buf_view>);
+static_assert(sizeof(xu::shared_buf_view) == 2 * sizeof(void*));
+
+/**
+  @brief  Same as outputLoop in test_shared_buf.cpp, but never touches a refcount
+  */
+static void outputLoop(xu::shared_buf_view view)
+{
+  std::cout << "Test:";
+  for (auto cit = view.begin(); cit != view.end(); cit++)
+  {
+    if (cit != view.begin())
+    {
+      std::cout << ',';
+    }
+
+    std::cout << (int)*cit;
+  }
+  std::cout << '\n';
+}
+
+int main()
+{
+  xu::shared_buf buf(6);
+  std::iota(buf.begin(), buf.end(), 1);
+
+  /* implicit conversions from shared_buf, slices and unique_buf */
+  outputLoop(buf);
+  outputLoop(buf.slice(2, 3));
+
+  xu::unique_buf ubuf(3);
+  std::iota(ubuf.begin(), ubuf.end(), 3);
+  outputLoop(ubuf);
+
+  xu::shared_buf_view view = buf;
+  std::cout << "view=" << view << " subview=" << view.subview(1, 2) << std::endl;
+  CHECK(view[5] == 6);
+  CHECK(view.data() == buf.data());
+
+  /* comparisons are by content */
+  CHECK(buf.slice(2, 3) == ubuf);
+  CHECK(buf.deepCopy() == buf);
+  CHECK(buf != ubuf);
+  CHECK(view.subview(0, 2) < view);
+  CHECK(view.subview(1, 1) > view);
+  CHECK(xu::shared_buf_view() == xu::shared_buf(0));
+
+  xu::shared_buf high = xu::shared_buf::fromHex("ff");
+  xu::shared_buf low = xu::shared_buf::fromHex("01");
+  CHECK(low < high);
+
+  /* hashing */
+  std::unordered_set<xu::shared_buf> set;
+  set.insert(buf);
+  set.insert(buf.deepCopy());
+  set.insert(buf.slice(2, 3));
+  CHECK(set.size() == 2);
+  CHECK(std::hash<xu::shared_buf_view>()(ubuf) == std::hash<xu::shared_buf>()(buf.slice(2, 3)));
+  std::cout << "distinct buffers=" << set.size() << std::endl;
+
+  try
+  {
+    view.subview(5, 2);
+  }
+  catch (const std::out_of_range& e)
+  {
+    std::cout << "caught: " << e.what() << std::endl;
+  }
+}
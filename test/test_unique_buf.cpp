@@ -0,0 +1,78 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2020 Kevin Xu
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include <iostream>
+#include <numeric>
+#include <type_traits>
+
+#include "check.hpp"
+#include "unique_buf.hpp"
+
+static_assert(not std::is_copy_constructible_v<xu::unique_buf>);
+static_assert(std::is_nothrow_move_constructible_v<xu::unique_buf>);
+
+/**
+  @brief  Fill phase: the buffer only ever moves, so there is no refcount traffic
+  */
+static xu::unique_buf fill(xu::unique_buf buf)
+{
+  std::iota(buf.begin(), buf.end(), 1);
+  return buf;
+}
+
+int main()
+{
+  xu::unique_buf buf = fill(xu::unique_buf(6));
+  std::cout << "unique=" << buf << std::endl;
+
+  const uint8_t* bytes = buf.data();
+  buf[0] = 0xaa;
+  CHECK(buf.at(5) == 6);
+
+  std::cout << "reversed=";
+  for (auto rit = buf.rbegin(); rit != buf.rend(); rit++)
+  {
+    std::cout << (int)*rit << ' ';
+  }
+  std::cout << std::endl;
+
+  xu::shared_buf shared = std::move(buf).share();
+  CHECK(shared.data() == bytes);
+  CHECK(shared.size() == 6);
+  CHECK(buf.size() == 0);
+  std::cout << "shared=" << shared << std::endl;
+
+  xu::unique_buf moved(3);
+  moved = xu::unique_buf(2);
+  CHECK(moved.size() == 2);
+
+  try
+  {
+    moved.at(2);
+  }
+  catch (const std::out_of_range& e)
+  {
+    std::cout << "caught: " << e.what() << std::endl;
+  }
+}